@@ -0,0 +1,177 @@
+#define _POSIX_C_SOURCE 200809L
+#include "hash_table.h"
+#include <stdlib.h>
+#include <string.h>
+#include "log.h"
+
+#define HASH_TABLE_MIN_CAPACITY 16
+
+static uint32_t hash_string(const char *key) {
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (const unsigned char *c = (const unsigned char *)key; *c; ++c) {
+		hash ^= *c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t hash_id(uint64_t id) {
+	// Finalizer of MurmurHash3, ids are usually sequential
+	id ^= id >> 33;
+	id *= 0xff51afd7ed558ccdull;
+	id ^= id >> 33;
+	id *= 0xc4ceb9fe1a85ec53ull;
+	id ^= id >> 33;
+	return (uint32_t)id;
+}
+
+hash_table_t *create_hash_table(void) {
+	hash_table_t *table = calloc(1, sizeof(hash_table_t));
+	if (!table) {
+		return NULL;
+	}
+	table->capacity = HASH_TABLE_MIN_CAPACITY;
+	table->entries = calloc(table->capacity, sizeof(struct hash_table_entry));
+	if (!table->entries) {
+		free(table);
+		return NULL;
+	}
+	return table;
+}
+
+void hash_table_free(hash_table_t *table) {
+	if (!table) {
+		return;
+	}
+	for (size_t i = 0; i < table->capacity; ++i) {
+		free(table->entries[i].key);
+	}
+	free(table->entries);
+	free(table);
+}
+
+static bool entry_matches(struct hash_table_entry *entry, uint32_t hash,
+		const char *key, uint64_t id) {
+	if (!entry->value || entry->hash != hash) {
+		return false;
+	}
+	return key ? strcmp(entry->key, key) == 0 : entry->id == id;
+}
+
+/**
+ * Returns the slot of the key, or the empty slot where it would go.
+ */
+static size_t find_slot(hash_table_t *table, uint32_t hash,
+		const char *key, uint64_t id) {
+	size_t mask = table->capacity - 1;
+	size_t i = hash & mask;
+	while (table->entries[i].value &&
+			!entry_matches(&table->entries[i], hash, key, id)) {
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+static bool resize(hash_table_t *table, size_t capacity) {
+	struct hash_table_entry *entries =
+		calloc(capacity, sizeof(struct hash_table_entry));
+	if (!sway_assert(entries, "Unable to resize hash table")) {
+		return false;
+	}
+	struct hash_table_entry *old = table->entries;
+	size_t old_capacity = table->capacity;
+	table->entries = entries;
+	table->capacity = capacity;
+	for (size_t i = 0; i < old_capacity; ++i) {
+		if (old[i].value) {
+			size_t mask = capacity - 1;
+			size_t j = old[i].hash & mask;
+			while (entries[j].value) {
+				j = (j + 1) & mask;
+			}
+			entries[j] = old[i];
+		}
+	}
+	free(old);
+	return true;
+}
+
+static void set(hash_table_t *table, uint32_t hash, const char *key,
+		uint64_t id, void *value) {
+	if (!sway_assert(value, "Hash table values must not be NULL")) {
+		return;
+	}
+	// Keep the load factor under 3/4 so probe sequences stay short
+	if ((table->length + 1) * 4 > table->capacity * 3 &&
+			!resize(table, table->capacity * 2)) {
+		return;
+	}
+	size_t i = find_slot(table, hash, key, id);
+	struct hash_table_entry *entry = &table->entries[i];
+	if (!entry->value) {
+		if (key) {
+			entry->key = strdup(key);
+			if (!sway_assert(entry->key, "Unable to allocate hash table key")) {
+				return;
+			}
+		}
+		entry->hash = hash;
+		entry->id = id;
+		table->length++;
+	}
+	entry->value = value;
+}
+
+static void del(hash_table_t *table, uint32_t hash, const char *key,
+		uint64_t id, void *value) {
+	size_t mask = table->capacity - 1;
+	size_t i = find_slot(table, hash, key, id);
+	struct hash_table_entry *entry = &table->entries[i];
+	if (!entry->value || (value && entry->value != value)) {
+		return;
+	}
+	free(entry->key);
+	memset(entry, 0, sizeof(struct hash_table_entry));
+	table->length--;
+
+	// Shift the following entries of the probe sequence back, so lookups
+	// don't stop early at the new hole
+	size_t hole = i;
+	for (size_t j = (i + 1) & mask; table->entries[j].value;
+			j = (j + 1) & mask) {
+		size_t home = table->entries[j].hash & mask;
+		// Move the entry if its home slot isn't between the hole and it
+		if (((j - home) & mask) >= ((j - hole) & mask)) {
+			table->entries[hole] = table->entries[j];
+			memset(&table->entries[j], 0, sizeof(struct hash_table_entry));
+			hole = j;
+		}
+	}
+}
+
+void *hash_table_get(hash_table_t *table, const char *key) {
+	uint32_t hash = hash_string(key);
+	return table->entries[find_slot(table, hash, key, 0)].value;
+}
+
+void hash_table_set(hash_table_t *table, const char *key, void *value) {
+	set(table, hash_string(key), key, 0, value);
+}
+
+void hash_table_del(hash_table_t *table, const char *key, void *value) {
+	del(table, hash_string(key), key, 0, value);
+}
+
+void *hash_table_get_id(hash_table_t *table, uint64_t id) {
+	uint32_t hash = hash_id(id);
+	return table->entries[find_slot(table, hash, NULL, id)].value;
+}
+
+void hash_table_set_id(hash_table_t *table, uint64_t id, void *value) {
+	set(table, hash_id(id), NULL, id, value);
+}
+
+void hash_table_del_id(hash_table_t *table, uint64_t id, void *value) {
+	del(table, hash_id(id), NULL, id, value);
+}
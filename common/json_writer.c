@@ -0,0 +1,262 @@
+#include "json_writer.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log.h"
+
+void json_writer_init(struct json_writer *writer,
+		char *data, size_t len, size_t size) {
+	memset(writer, 0, sizeof(struct json_writer));
+	writer->data = data;
+	writer->len = len;
+	writer->size = size;
+}
+
+void json_writer_finish(struct json_writer *writer) {
+	free(writer->data);
+	json_writer_init(writer, NULL, 0, 0);
+}
+
+static bool grow(struct json_writer *writer, size_t len) {
+	if (writer->failed) {
+		return false;
+	}
+	// Keep room for the terminating NUL
+	if (writer->len + len < writer->size) {
+		return true;
+	}
+	size_t size = writer->size ? writer->size : 256;
+	while (writer->len + len >= size) {
+		size *= 2;
+	}
+	char *data = realloc(writer->data, size);
+	if (!data) {
+		sway_log(SWAY_ERROR, "Unable to grow JSON buffer to %zu bytes", size);
+		writer->failed = true;
+		return false;
+	}
+	writer->data = data;
+	writer->size = size;
+	return true;
+}
+
+static void append(struct json_writer *writer, const char *str, size_t len) {
+	if (!grow(writer, len)) {
+		return;
+	}
+	memcpy(writer->data + writer->len, str, len);
+	writer->len += len;
+	writer->data[writer->len] = '\0';
+}
+
+static void append_str(struct json_writer *writer, const char *str) {
+	append(writer, str, strlen(str));
+}
+
+/**
+ * Writes what separates a value from the previous one, which json-c spaces out
+ * inside arrays.
+ */
+static void begin_value(struct json_writer *writer) {
+	if (writer->after_key) {
+		writer->after_key = false;
+		return;
+	}
+	if (writer->depth > 0) {
+		if (writer->has_items[writer->depth]) {
+			append_str(writer, ",");
+		}
+		append_str(writer, " ");
+		writer->has_items[writer->depth] = true;
+	}
+}
+
+static void append_escaped(struct json_writer *writer, const char *str) {
+	static const char hex[] = "0123456789abcdef";
+	append_str(writer, "\"");
+	const char *start = str;
+	for (const char *c = str; *c; ++c) {
+		unsigned char ch = *c;
+		const char *escape = NULL;
+		char unicode[7];
+		switch (ch) {
+		case '\b':
+			escape = "\\b";
+			break;
+		case '\n':
+			escape = "\\n";
+			break;
+		case '\r':
+			escape = "\\r";
+			break;
+		case '\t':
+			escape = "\\t";
+			break;
+		case '\f':
+			escape = "\\f";
+			break;
+		case '"':
+			escape = "\\\"";
+			break;
+		case '\\':
+			escape = "\\\\";
+			break;
+		case '/':
+			// json-c escapes slashes unless told otherwise
+			escape = "\\/";
+			break;
+		default:
+			if (ch < ' ') {
+				snprintf(unicode, sizeof(unicode), "\\u00%c%c",
+					hex[ch >> 4], hex[ch & 0xf]);
+				escape = unicode;
+			}
+			break;
+		}
+		if (escape) {
+			append(writer, start, c - start);
+			append_str(writer, escape);
+			start = c + 1;
+		}
+	}
+	append_str(writer, start);
+	append_str(writer, "\"");
+}
+
+static void begin_container(struct json_writer *writer, const char *open) {
+	begin_value(writer);
+	if (!sway_assert(writer->depth < JSON_WRITER_MAX_DEPTH,
+				"JSON nesting is too deep")) {
+		writer->failed = true;
+		return;
+	}
+	append_str(writer, open);
+	writer->has_items[++writer->depth] = false;
+}
+
+static void end_container(struct json_writer *writer, const char *close) {
+	if (!sway_assert(writer->depth > 0 && !writer->after_key,
+				"Unbalanced JSON writer")) {
+		writer->failed = true;
+		return;
+	}
+	writer->depth--;
+	append_str(writer, close);
+}
+
+void json_writer_object_begin(struct json_writer *writer) {
+	begin_container(writer, "{");
+}
+
+void json_writer_object_end(struct json_writer *writer) {
+	end_container(writer, " }");
+}
+
+void json_writer_array_begin(struct json_writer *writer) {
+	begin_container(writer, "[");
+}
+
+void json_writer_array_end(struct json_writer *writer) {
+	end_container(writer, " ]");
+}
+
+void json_writer_key(struct json_writer *writer, const char *key) {
+	writer->after_key = false;
+	begin_value(writer);
+	append_escaped(writer, key);
+	append_str(writer, ": ");
+	writer->after_key = true;
+}
+
+void json_writer_string(struct json_writer *writer, const char *str) {
+	if (!str) {
+		json_writer_null(writer);
+		return;
+	}
+	begin_value(writer);
+	append_escaped(writer, str);
+}
+
+void json_writer_int(struct json_writer *writer, int64_t value) {
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%" PRId64, value);
+	begin_value(writer);
+	append_str(writer, buf);
+}
+
+void json_writer_double(struct json_writer *writer, double value) {
+	char buf[64];
+	if (isnan(value)) {
+		strcpy(buf, "NaN");
+	} else if (isinf(value)) {
+		strcpy(buf, value > 0 ? "Infinity" : "-Infinity");
+	} else {
+		snprintf(buf, sizeof(buf), "%.17g", value);
+		// The decimal separator depends on the locale
+		char *comma = strchr(buf, ',');
+		if (comma) {
+			*comma = '.';
+		}
+		// Like json-c, keep integral values recognizable as doubles
+		if (!strpbrk(buf, ".e")) {
+			strcat(buf, ".0");
+		}
+	}
+	begin_value(writer);
+	append_str(writer, buf);
+}
+
+void json_writer_bool(struct json_writer *writer, bool value) {
+	begin_value(writer);
+	append_str(writer, value ? "true" : "false");
+}
+
+void json_writer_null(struct json_writer *writer) {
+	begin_value(writer);
+	append_str(writer, "null");
+}
+
+void json_writer_raw(struct json_writer *writer, const char *json, size_t len) {
+	begin_value(writer);
+	append(writer, json, len);
+}
+
+void json_writer_add_string(struct json_writer *writer, const char *key,
+		const char *str) {
+	json_writer_key(writer, key);
+	json_writer_string(writer, str);
+}
+
+void json_writer_add_int(struct json_writer *writer, const char *key,
+		int64_t value) {
+	json_writer_key(writer, key);
+	json_writer_int(writer, value);
+}
+
+void json_writer_add_double(struct json_writer *writer, const char *key,
+		double value) {
+	json_writer_key(writer, key);
+	json_writer_double(writer, value);
+}
+
+void json_writer_add_bool(struct json_writer *writer, const char *key,
+		bool value) {
+	json_writer_key(writer, key);
+	json_writer_bool(writer, value);
+}
+
+void json_writer_add_null(struct json_writer *writer, const char *key) {
+	json_writer_key(writer, key);
+	json_writer_null(writer);
+}
+
+size_t json_writer_reserve(struct json_writer *writer, size_t len) {
+	size_t offset = writer->len;
+	if (grow(writer, len)) {
+		writer->len += len;
+		writer->data[writer->len] = '\0';
+	}
+	return offset;
+}
@@ -0,0 +1,122 @@
+#include "pool.h"
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log.h"
+
+// Bytes of objects in a slab, unless a single object is larger
+#define POOL_SLAB_SIZE 16384
+
+// Objects and slab headers are aligned like malloc does
+#define POOL_ALIGN alignof(max_align_t)
+
+static list_t *registered_stats = NULL;
+
+static size_t align_size(size_t size) {
+	return (size + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN;
+}
+
+pool_t *create_pool(const char *name, size_t object_size) {
+	pool_t *pool = calloc(1, sizeof(pool_t));
+	if (!pool) {
+		return NULL;
+	}
+	pool->stats.name = name;
+	// Free objects store the link to the next one
+	pool->object_size = align_size(object_size < sizeof(void *) ?
+		sizeof(void *) : object_size);
+	pool->slab_objects = POOL_SLAB_SIZE / pool->object_size;
+	if (pool->slab_objects == 0) {
+		pool->slab_objects = 1;
+	}
+	pool_stats_register(&pool->stats);
+	return pool;
+}
+
+void pool_destroy(pool_t *pool) {
+	if (!pool) {
+		return;
+	}
+	pool_stats_unregister(&pool->stats);
+	void *slab = pool->slabs;
+	while (slab) {
+		void *next = *(void **)slab;
+		free(slab);
+		slab = next;
+	}
+	free(pool);
+}
+
+static bool pool_grow(pool_t *pool) {
+	size_t header = align_size(sizeof(void *));
+	size_t size = header + pool->slab_objects * pool->object_size;
+	void *slab = malloc(size);
+	if (!slab) {
+		return false;
+	}
+	*(void **)slab = pool->slabs;
+	pool->slabs = slab;
+	pool->fresh = (char *)slab + header;
+	pool->fresh_left = pool->slab_objects;
+	pool->stats.bytes += size;
+	return true;
+}
+
+void *pool_alloc(pool_t *pool) {
+	void *object;
+	if (pool->free_objects) {
+		object = pool->free_objects;
+		pool->free_objects = *(void **)object;
+		pool->stats.cached--;
+		pool->stats.reuses++;
+	} else {
+		if (!pool->fresh_left && !pool_grow(pool)) {
+			sway_log(SWAY_ERROR, "Unable to allocate slab for pool %s",
+				pool->stats.name);
+			return NULL;
+		}
+		object = pool->fresh;
+		pool->fresh += pool->object_size;
+		pool->fresh_left--;
+	}
+	memset(object, 0, pool->object_size);
+	pool->stats.allocations++;
+	pool->stats.in_use++;
+	return object;
+}
+
+void pool_free(pool_t *pool, void *object) {
+	if (!object) {
+		return;
+	}
+	*(void **)object = pool->free_objects;
+	pool->free_objects = object;
+	pool->stats.in_use--;
+	pool->stats.cached++;
+}
+
+void pool_stats_register(struct pool_stats *stats) {
+	if (!registered_stats) {
+		registered_stats = create_list();
+	}
+	list_add(registered_stats, stats);
+}
+
+void pool_stats_unregister(struct pool_stats *stats) {
+	if (!registered_stats) {
+		return;
+	}
+	int index = list_find(registered_stats, stats);
+	if (index != -1) {
+		list_del(registered_stats, index);
+	}
+	if (!registered_stats->length) {
+		list_free(registered_stats);
+		registered_stats = NULL;
+	}
+}
+
+list_t *pool_stats_get_all(void) {
+	return registered_stats;
+}
@@ -0,0 +1,39 @@
+#ifndef _SWAY_HASH_TABLE_H
+#define _SWAY_HASH_TABLE_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct hash_table_entry {
+	uint32_t hash;
+	char *key; // NULL for integer keys
+	uint64_t id;
+	void *value; // NULL for empty slots
+};
+
+/**
+ * An open addressing hash table, keyed either by string or by integer. A table
+ * must only be used with one kind of key. String keys are copied. Values must
+ * not be NULL.
+ */
+typedef struct {
+	size_t capacity; // Always a power of two
+	size_t length;
+	struct hash_table_entry *entries;
+} hash_table_t;
+
+hash_table_t *create_hash_table(void);
+void hash_table_free(hash_table_t *table);
+
+void *hash_table_get(hash_table_t *table, const char *key);
+// Replaces the value of an existing key
+void hash_table_set(hash_table_t *table, const char *key, void *value);
+// Removes the key only if it currently maps to the given value, or to
+// anything if value is NULL
+void hash_table_del(hash_table_t *table, const char *key, void *value);
+
+void *hash_table_get_id(hash_table_t *table, uint64_t id);
+void hash_table_set_id(hash_table_t *table, uint64_t id, void *value);
+void hash_table_del_id(hash_table_t *table, uint64_t id, void *value);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef _SWAY_JSON_WRITER_H
+#define _SWAY_JSON_WRITER_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_WRITER_MAX_DEPTH 64
+
+/**
+ * Writes JSON text as values are produced, without building a tree of objects
+ * first. The output is formatted like json-c formats it by default, so replies
+ * don't change depending on how they were built.
+ *
+ * The buffer is grown with realloc and kept NUL-terminated. It can be borrowed
+ * from somewhere else, in which case the owner takes back data and size once
+ * done, since growing it may have moved it.
+ */
+struct json_writer {
+	char *data;
+	size_t len;
+	size_t size;
+	bool failed; // An allocation failed or the nesting was wrong
+	int depth;
+	bool has_items[JSON_WRITER_MAX_DEPTH + 1];
+	bool after_key;
+};
+
+void json_writer_init(struct json_writer *writer,
+		char *data, size_t len, size_t size);
+// Frees the buffer, for writers which own it
+void json_writer_finish(struct json_writer *writer);
+
+void json_writer_object_begin(struct json_writer *writer);
+void json_writer_object_end(struct json_writer *writer);
+void json_writer_array_begin(struct json_writer *writer);
+void json_writer_array_end(struct json_writer *writer);
+void json_writer_key(struct json_writer *writer, const char *key);
+
+// Writes null if str is NULL
+void json_writer_string(struct json_writer *writer, const char *str);
+void json_writer_int(struct json_writer *writer, int64_t value);
+void json_writer_double(struct json_writer *writer, double value);
+void json_writer_bool(struct json_writer *writer, bool value);
+void json_writer_null(struct json_writer *writer);
+// Writes a value which is already serialized
+void json_writer_raw(struct json_writer *writer, const char *json, size_t len);
+
+// Shorthands for a key followed by its value
+void json_writer_add_string(struct json_writer *writer, const char *key,
+		const char *str);
+void json_writer_add_int(struct json_writer *writer, const char *key,
+		int64_t value);
+void json_writer_add_double(struct json_writer *writer, const char *key,
+		double value);
+void json_writer_add_bool(struct json_writer *writer, const char *key,
+		bool value);
+void json_writer_add_null(struct json_writer *writer, const char *key);
+
+/**
+ * Appends len bytes outside of any value, for the caller to fill in once the
+ * writer is done. Returns their offset in data, which stays valid when data
+ * moves.
+ */
+size_t json_writer_reserve(struct json_writer *writer, size_t len);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef _SWAY_POOL_H
+#define _SWAY_POOL_H
+#include <stddef.h>
+#include "list.h"
+
+/**
+ * Allocation counters of a pool, or of anything else recycling memory.
+ */
+struct pool_stats {
+	const char *name;
+	size_t allocations; // Objects handed out
+	size_t reuses; // Allocations served by a recycled object
+	size_t in_use;
+	size_t cached; // Recycled objects waiting to be reused
+	size_t bytes; // Memory held, including objects in use
+};
+
+/**
+ * A pool of zero-initialized objects of a fixed size, carved out of larger
+ * slabs. Freed objects are kept for reuse rather than given back to malloc, so
+ * the memory of a pool only grows until it is destroyed.
+ */
+typedef struct {
+	struct pool_stats stats;
+	size_t object_size;
+	size_t slab_objects;
+	void *free_objects; // Linked through their first bytes
+	void *slabs; // Linked through their first bytes
+	char *fresh; // Never used objects of the last slab
+	size_t fresh_left;
+} pool_t;
+
+pool_t *create_pool(const char *name, size_t object_size);
+void pool_destroy(pool_t *pool);
+void *pool_alloc(pool_t *pool);
+void pool_free(pool_t *pool, void *object);
+
+/**
+ * Counters are registered globally so they can be inspected for debugging.
+ * Pools register their own.
+ */
+void pool_stats_register(struct pool_stats *stats);
+void pool_stats_unregister(struct pool_stats *stats);
+// struct pool_stats *, NULL if nothing was registered
+list_t *pool_stats_get_all(void);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef _SWAY_BENCHMARK_H
+#define _SWAY_BENCHMARK_H
+
+struct sway_output;
+
+/**
+ * The benchmark renders -D benchmark=<frames> frames in each of the tiled,
+ * tabbed, stacked and floating layouts with scripted damage, prints the
+ * frame and arrange timings as JSON on stdout and exits.
+ *
+ * It is meant to be run on the headless backend, where it measures the
+ * windows started by the config once they have settled.
+ */
+void benchmark_start(int frames);
+
+/**
+ * Called on every output frame, before the output is repainted.
+ */
+void benchmark_handle_frame(struct sway_output *output);
+
+#endif
@@ -143,6 +143,7 @@ sway_cmd cmd_hide_edge_borders;
 sway_cmd cmd_include;
 sway_cmd cmd_inhibit_idle;
 sway_cmd cmd_input;
+sway_cmd cmd_ipc_max_queued_bytes;
 sway_cmd cmd_seat;
 sway_cmd cmd_ipc;
 sway_cmd cmd_kill;
@@ -150,6 +151,7 @@ sway_cmd cmd_layout;
 sway_cmd cmd_log_colors;
 sway_cmd cmd_mark;
 sway_cmd cmd_max_render_time;
+sway_cmd cmd_max_title_update_rate;
 sway_cmd cmd_mode;
 sway_cmd cmd_mouse_warping;
 sway_cmd cmd_move;
@@ -290,6 +292,7 @@ sway_cmd output_cmd_toggle;
 sway_cmd output_cmd_transform;
 
 sway_cmd seat_cmd_attach;
+sway_cmd seat_cmd_coalesce_motion;
 sway_cmd seat_cmd_cursor;
 sway_cmd seat_cmd_fallback;
 sway_cmd seat_cmd_hide_cursor;
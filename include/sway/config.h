@@ -193,6 +193,12 @@ enum seat_config_allow_constrain {
 	CONSTRAIN_DISABLE,
 };
 
+enum seat_config_coalesce_motion {
+	COALESCE_MOTION_DEFAULT, // the default is currently disabled
+	COALESCE_MOTION_ENABLE,
+	COALESCE_MOTION_DISABLE,
+};
+
 enum seat_config_shortcuts_inhibit {
 	SHORTCUTS_INHIBIT_DEFAULT, // the default is currently enabled
 	SHORTCUTS_INHIBIT_ENABLE,
@@ -224,6 +230,7 @@ struct seat_config {
 	int hide_cursor_timeout;
 	enum seat_config_hide_cursor_when_typing hide_cursor_when_typing;
 	enum seat_config_allow_constrain allow_constrain;
+	enum seat_config_coalesce_motion coalesce_motion;
 	enum seat_config_shortcuts_inhibit shortcuts_inhibit;
 	enum seat_keyboard_grouping keyboard_grouping;
 	uint32_t idle_inhibit_sources, idle_wake_sources;
@@ -246,6 +253,8 @@ enum scale_filter_mode {
 	SCALE_FILTER_SMART,
 };
 
+#define MAX_RENDER_TIME_AUTO -2
+
 /**
  * Size and position configuration for a particular output.
  *
@@ -262,7 +271,7 @@ struct output_config {
 	enum scale_filter_mode scale_filter;
 	int32_t transform;
 	enum wl_output_subpixel subpixel;
-	int max_render_time; // In milliseconds
+	int max_render_time; // In milliseconds, or MAX_RENDER_TIME_AUTO
 	int adaptive_sync;
 
 	char *background;
@@ -493,6 +502,8 @@ struct sway_config {
 	int titlebar_h_padding;
 	int titlebar_v_padding;
 	size_t urgent_timeout;
+	int max_title_update_rate; // Per view and second, 0 for unlimited
+	size_t ipc_max_queued_bytes; // Per IPC client, which is disconnected past it
 	enum sway_fowa focus_on_window_activation;
 	enum sway_popup_during_fullscreen popup_during_fullscreen;
 	enum xwayland_mode xwayland;
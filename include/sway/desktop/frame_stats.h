@@ -0,0 +1,107 @@
+#ifndef _SWAY_FRAME_STATS_H
+#define _SWAY_FRAME_STATS_H
+#include <stdint.h>
+#include <time.h>
+
+#define HISTOGRAM_BUCKETS 128
+#define RENDER_TIME_SAMPLES 128
+
+/**
+ * A histogram of durations in microseconds. Buckets grow exponentially with
+ * four buckets per power of two, so percentiles are accurate to within 25%
+ * while the histogram has a fixed size.
+ */
+struct sway_histogram {
+	uint64_t buckets[HISTOGRAM_BUCKETS];
+	uint64_t count;
+};
+
+/**
+ * Frame timing statistics of an output, collected since it was created.
+ *
+ * Timestamps use the presentation clock of the backend, except for the
+ * render time which is measured with CLOCK_MONOTONIC.
+ */
+struct sway_frame_stats {
+	struct sway_histogram render_time; // CPU time spent in output_render
+	struct sway_histogram damage_to_commit; // From the frame event to commit
+	struct sway_histogram present_interval; // While rendering continuously
+	uint64_t frames; // Committed frames
+	uint64_t missed_frames; // Refresh cycles missed while rendering continuously
+
+	struct timespec frame_event; // Of the frame being rendered, if any
+	struct timespec committed_frame_event; // Of the frame waiting for present
+	struct timespec last_present;
+};
+
+/**
+ * Picks the max_render_time of an output with max_render_time auto from the
+ * durations of its recent frames.
+ */
+struct sway_render_time_auto {
+	uint32_t samples[RENDER_TIME_SAMPLES]; // Render and commit, in usec
+	int nsamples, next;
+
+	int msec; // The current max_render_time, 0 for off
+	int frames_until_update;
+
+	// After a missed frame, max_render_time isn't lowered below backoff_msec
+	// for backoff_frames frames
+	int backoff_msec;
+	int backoff_frames;
+};
+
+void histogram_add(struct sway_histogram *histogram, uint64_t usec);
+
+/**
+ * Returns the upper bound of the bucket containing the given percentile
+ * (between 0 and 100), or 0 if the histogram is empty.
+ */
+uint64_t histogram_get_percentile(const struct sway_histogram *histogram,
+		double percentile);
+
+/**
+ * Returns the time from start to end in microseconds, or 0 if end is before
+ * start.
+ */
+uint64_t timespec_diff_usec(const struct timespec *start,
+		const struct timespec *end);
+
+/**
+ * Called on the output frame event, which starts rendering a new frame.
+ */
+void frame_stats_handle_frame(struct sway_frame_stats *stats,
+		const struct timespec *when);
+
+/**
+ * Called after a frame was rendered and committed. render_start and
+ * render_end use CLOCK_MONOTONIC, when uses the presentation clock.
+ */
+void frame_stats_handle_commit(struct sway_frame_stats *stats,
+		const struct timespec *render_start, const struct timespec *render_end,
+		const struct timespec *when);
+
+/**
+ * Returns the number of refresh cycles missed before this presentation.
+ */
+uint64_t frame_stats_handle_present(struct sway_frame_stats *stats,
+		const struct timespec *when, uint32_t refresh_nsec);
+
+void render_time_auto_reset(struct sway_render_time_auto *tuner);
+
+void render_time_auto_add_sample(struct sway_render_time_auto *tuner,
+		uint64_t usec);
+
+/**
+ * Raise max_render_time right away after a frame missed its refresh.
+ */
+void render_time_auto_handle_missed(struct sway_render_time_auto *tuner);
+
+/**
+ * Returns the max_render_time to use for the next frame in milliseconds, or
+ * 0 to render right after the refresh.
+ */
+int render_time_auto_get_msec(struct sway_render_time_auto *tuner,
+		uint32_t refresh_nsec);
+
+#endif
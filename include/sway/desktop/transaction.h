@@ -1,6 +1,10 @@
 #ifndef _SWAY_TRANSACTION_H
 #define _SWAY_TRANSACTION_H
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "list.h"
+#include "sway/desktop/frame_stats.h"
 
 /**
  * Transactions enable us to perform atomic layout updates.
@@ -22,6 +26,58 @@
 struct sway_transaction_instruction;
 struct sway_view;
 
+/**
+ * How long a client takes to acknowledge configures, learned from the
+ * transactions it took part in. The timeout of a transaction follows from the
+ * latency of the clients it waits for.
+ */
+struct sway_client_latency_stats {
+	double ema_ms; // Exponential moving average
+	double p95_ms; // Over the recent configures
+	size_t samples;
+	size_t timeouts;
+	// The client is too slow to hold transactions for the full timeout
+	bool slow;
+};
+
+#define TRANSACTION_HISTORY 64
+
+/**
+ * The life of one transaction, from commit to apply. Durations are in
+ * microseconds.
+ */
+struct sway_transaction_record {
+	uint64_t id;
+	size_t nodes;
+	size_t configures; // Configures sent to views
+	size_t timeouts; // Views which hadn't acked when the timeout fired
+	uint64_t wait_usec; // From commit until every view was ready
+	uint64_t apply_usec; // From commit until the new state was applied
+	uint32_t timeout_ms;
+	bool timed_out;
+};
+
+struct sway_transaction_app_timeouts {
+	char *app_id; // Or the class of xwayland views
+	size_t count;
+};
+
+/**
+ * Transaction statistics collected since startup, along with the records of
+ * the most recently applied transactions.
+ */
+struct sway_transaction_stats {
+	uint64_t committed, applied, timed_out;
+	struct sway_histogram wait_time;
+	struct sway_histogram apply_time;
+
+	// Ring buffer, oldest first starting at history_next once full
+	struct sway_transaction_record history[TRANSACTION_HISTORY];
+	size_t history_len, history_next;
+
+	list_t *app_timeouts; // struct sway_transaction_app_timeouts *
+};
+
 /**
  * Find all dirty containers, create and commit a transaction containing them,
  * and unmark them as dirty.
@@ -51,4 +107,14 @@ void transaction_notify_view_ready_by_serial(struct sway_view *view,
 void transaction_notify_view_ready_by_geometry(struct sway_view *view,
 		double x, double y, int width, int height);
 
+/**
+ * Get the configure latency of the client of a view. Returns false if the
+ * client hasn't taken part in any transaction yet. The IPC description of the
+ * view is invalidated when the latency changes.
+ */
+bool transaction_get_view_latency(struct sway_view *view,
+		struct sway_client_latency_stats *stats);
+
+const struct sway_transaction_stats *transaction_get_stats(void);
+
 #endif
@@ -76,6 +76,13 @@ struct sway_cursor {
 	enum seat_config_hide_cursor_when_typing hide_when_typing;
 
 	size_t pressed_button_count;
+
+	// When coalescing motion, pointer motion only moves the cursor image and
+	// the rest is handled once all pending input events have been read
+	bool coalesce_motion;
+	bool motion_pending, frame_pending;
+	uint32_t motion_time_msec;
+	struct wl_event_source *motion_idle;
 };
 
 struct sway_node;
@@ -94,6 +101,12 @@ struct sway_cursor *sway_cursor_create(struct sway_seat *seat);
  */
 void cursor_rebase(struct sway_cursor *cursor);
 void cursor_rebase_all(void);
+
+/**
+ * Handle the pointer motion held back while coalescing motion, if any. Input
+ * which depends on the pointer focus must call this first.
+ */
+void cursor_flush_motion(struct sway_cursor *cursor);
 void cursor_update_image(struct sway_cursor *cursor, struct sway_node *node);
 
 void cursor_handle_activity_from_idle_source(struct sway_cursor *cursor,
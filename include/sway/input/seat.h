@@ -9,6 +9,7 @@
 #include "sway/input/input-manager.h"
 #include "sway/input/tablet.h"
 #include "sway/input/text_input.h"
+#include "hash_table.h"
 
 struct sway_seat;
 
@@ -75,6 +76,13 @@ struct sway_seat {
 
 	bool has_focus;
 	struct wl_list focus_stack; // list of containers in focus order
+
+	// Most recently focused descendants of each node, derived from the focus
+	// stack. Rebuilt from scratch when the tree has changed.
+	hash_table_t *focus_inactive; // node id -> struct sway_focus_inactive
+	list_t *focus_inactive_entries; // struct sway_focus_inactive
+	bool focus_inactive_valid;
+	size_t focus_inactive_serial; // root->tree_serial when it was built
 	struct sway_workspace *workspace;
 	char *prev_workspace_name; // for workspace back_and_forth
 
@@ -3,19 +3,63 @@
 #ifdef HAVE_JSON
 #include <json.h>
 #endif
+#include "sway/desktop/transaction.h"
 #include "sway/tree/container.h"
 #include "sway/input/input-manager.h"
+#include "json_writer.h"
+#include "pool.h"
+
+/**
+ * The get_tree descriptions of workspaces and containers, including their
+ * children, are cached until they are invalidated.
+ *
+ * Invalidating a node also invalidates its ancestors, which embed its
+ * description, and its children, which describe their position among their
+ * siblings.
+ */
+void ipc_json_invalidate_node(struct sway_node *node);
+
+/**
+ * Invalidate all cached descriptions, for changes such as focus which affect
+ * nodes all over the tree.
+ */
+void ipc_json_invalidate_all(void);
+
+/**
+ * Free the cached description of a node being destroyed.
+ */
+void ipc_json_node_finish(struct sway_node *node);
 
 #ifdef HAVE_JSON
 json_object *ipc_json_get_version(void);
 
 json_object *ipc_json_get_binding_mode(void);
 
-json_object *ipc_json_describe_disabled_output(struct sway_output *o);
-json_object *ipc_json_describe_node(struct sway_node *node);
-json_object *ipc_json_describe_node_recursive(struct sway_node *node);
-json_object *ipc_json_describe_input(struct sway_input_device *device);
-json_object *ipc_json_describe_seat(struct sway_seat *seat);
+/**
+ * Nodes, outputs, inputs and seats are described by writing straight into a
+ * reply, since their descriptions make up most of the IPC traffic.
+ */
+void ipc_json_write_disabled_output(struct json_writer *writer,
+		struct sway_output *o);
+void ipc_json_write_node(struct json_writer *writer, struct sway_node *node);
+void ipc_json_write_node_recursive(struct json_writer *writer,
+		struct sway_node *node);
+/**
+ * Write the members of the description of a node, for callers adding their own
+ * to the object. The focused member can be left out for callers which have a
+ * different idea of focus.
+ */
+void ipc_json_write_node_members(struct json_writer *writer,
+		struct sway_node *node, bool recursive, bool focused);
+void ipc_json_write_input(struct json_writer *writer,
+		struct sway_input_device *device);
+void ipc_json_write_seat(struct json_writer *writer, struct sway_seat *seat);
+json_object *ipc_json_describe_output_stats(struct sway_output *output);
+json_object *ipc_json_describe_transaction_record(
+		const struct sway_transaction_record *record);
+json_object *ipc_json_describe_transaction_stats(
+		const struct sway_transaction_stats *stats);
+json_object *ipc_json_describe_pool_stats(const struct pool_stats *stats);
 json_object *ipc_json_describe_bar_config(struct bar_config *bar);
 #endif
 
@@ -1,15 +1,29 @@
 #ifndef _SWAY_OUTPUT_H
 #define _SWAY_OUTPUT_H
+#include <stdint.h>
 #include <time.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_output.h>
 #include "config.h"
+#include "sway/desktop/frame_stats.h"
 #include "sway/tree/node.h"
 #include "sway/tree/view.h"
 
 struct sway_server;
 struct sway_container;
+struct render_list;
+
+// Statistics about a single rendered frame, logged with -D render-stats
+struct sway_render_stats {
+	// Damaged pixels skipped because they were covered by opaque floating
+	// views
+	uint64_t culled_pixels;
+	size_t rect_draws; // Solid color quads submitted to the renderer
+	size_t scissors; // Scissor box changes
+	int damage_rects; // Before simplification
+	int damage_rects_simplified;
+};
 
 struct sway_output_state {
 	list_t *workspaces;
@@ -51,9 +65,20 @@ struct sway_output {
 		struct wl_signal destroy;
 	} events;
 
+	// Flattened draw list for the tiling and floating containers. It is
+	// marked dirty whenever a transaction is applied and rebuilt lazily on
+	// the next frame.
+	struct render_list *render_list;
+	bool render_list_dirty;
+
+	struct sway_render_stats render_stats; // of the last frame
+	struct sway_frame_stats frame_stats;
+
 	struct timespec last_presentation;
 	uint32_t refresh_nsec;
 	int max_render_time; // In milliseconds
+	bool max_render_time_auto;
+	struct sway_render_time_auto render_time_auto;
 	struct wl_event_source *repaint_timer;
 };
 
@@ -162,6 +187,8 @@ void render_rect(struct sway_output *output,
 		pixman_region32_t *output_damage, const struct wlr_box *_box,
 		float color[static 4]);
 
+void render_list_destroy(struct render_list *list);
+
 void premultiply_alpha(float color[4], float opacity);
 
 void scale_box(struct wlr_box *box, float scale);
@@ -94,19 +94,27 @@ struct sway_server {
 	// regardless of readiness.
 	size_t txn_timeout_ms;
 
-	// Stores a transaction after it has been committed, but is waiting for
+	// Stores the transactions which have been committed, but are waiting for
 	// views to ack the new dimensions before being applied. A queued
 	// transaction is frozen and must not have new instructions added to it.
-	struct sway_transaction *queued_transaction;
+	// Queued transactions never touch the same output, so each of them is
+	// applied as soon as its own views are ready.
+	list_t *queued_transactions; // struct sway_transaction *
 
-	// Stores a pending transaction that will be committed once the existing
-	// queued transaction is applied and freed. The pending transaction can be
-	// updated with new instructions as needed.
-	struct sway_transaction *pending_transaction;
+	// Stores the pending transactions, which will be committed once no queued
+	// transaction touches their outputs anymore. Pending transactions can be
+	// updated with new instructions as needed, and are merged when they come
+	// to touch the same output.
+	list_t *pending_transactions; // struct sway_transaction *
 
 	// Stores the nodes that have been marked as "dirty" and will be put into
 	// the pending transaction.
 	list_t *dirty_nodes;
+
+	// Stores the views with a title change waiting for the next frame.
+	list_t *dirty_titles; // struct sway_view *
+
+	struct wl_listener text_texture_ready;
 };
 
 extern struct sway_server server;
@@ -115,6 +123,11 @@ struct sway_debug {
 	bool noatomic;         // Ignore atomic layout updates
 	bool txn_timings;      // Log verbose messages about transactions
 	bool txn_wait;         // Always wait for the timeout before applying
+	bool noculling;        // Render views even when they are fully occluded
+	bool norectbatch;      // Draw each border rectangle with its own scissor
+	bool render_stats;     // Log per-frame render statistics
+	int damage_max_rects;  // Simplify damage to this many rectangles, 0 to disable
+	int benchmark_frames;  // Run the benchmark with this many frames per layout
 
 	enum {
 		DAMAGE_DEFAULT,    // Default behaviour
@@ -144,6 +157,7 @@ void handle_xwayland_surface(struct wl_listener *listener, void *data);
 void handle_server_decoration(struct wl_listener *listener, void *data);
 void handle_xdg_decoration(struct wl_listener *listener, void *data);
 void handle_pointer_constraint(struct wl_listener *listener, void *data);
+void handle_text_texture_ready(struct wl_listener *listener, void *data);
 void xdg_activation_v1_handle_request_activate(struct wl_listener *listener,
 	void *data);
 
@@ -0,0 +1,94 @@
+#ifndef _SWAY_TEXT_TEXTURE_H
+#define _SWAY_TEXT_TEXTURE_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <wayland-server-core.h>
+#include <wayland-server-protocol.h>
+#include <wlr/render/wlr_renderer.h>
+
+/**
+ * A line of text rendered into a texture, such as a container title or its
+ * marks.
+ *
+ * Text textures are shared by everything which renders the same text with the
+ * same font, scale, subpixel layout and colors, and are reference counted.
+ * Textures which are no longer referenced are kept in a least recently used
+ * cache in case the same text is needed again.
+ *
+ * Text is rasterized by a pool of worker threads; only the texture upload
+ * happens on the main loop.
+ */
+struct sway_text_texture;
+
+struct sway_text_texture_key {
+	const char *text;
+	const char *font;
+	bool markup;
+	float scale;
+	int height; // In buffer pixels
+	enum wl_output_subpixel subpixel;
+	float foreground[4];
+	float background[4];
+	struct wlr_renderer *renderer;
+};
+
+struct sway_text_texture_stats {
+	size_t hits, misses;
+	size_t entries; // Including the unused ones
+	size_t unused;
+};
+
+/**
+ * Start the rasterization workers. If this isn't called or fails, text is
+ * rasterized synchronously by text_texture_get. The ready listener is
+ * notified with each user of a text texture once its texture has been
+ * uploaded.
+ */
+bool text_texture_cache_init(struct wl_event_loop *loop,
+		struct wl_listener *ready);
+
+/**
+ * Stop the workers and destroy all unreferenced textures.
+ */
+void text_texture_cache_finish(void);
+
+/**
+ * Get a reference to the texture for the given text, queueing it for
+ * rasterization if it isn't cached. Returns NULL if there is no text.
+ *
+ * Until the new texture is ready, the texture of the fallback (usually the
+ * text being replaced) is rendered in its place. The fallback may be NULL.
+ */
+struct sway_text_texture *text_texture_get(
+		const struct sway_text_texture_key *key,
+		struct sway_text_texture *fallback);
+
+/**
+ * Release a reference returned by text_texture_get. Accepts NULL.
+ */
+void text_texture_unref(struct sway_text_texture *text);
+
+/**
+ * Have the ready listener notified with user once the texture is uploaded,
+ * so only what renders the text is damaged. Users are forgotten after that,
+ * and aren't added to textures which are ready already. A user added more
+ * than once is notified as many times, and has to be removed as many times.
+ * Both accept a NULL text.
+ */
+void text_texture_add_user(struct sway_text_texture *text, void *user);
+void text_texture_remove_user(struct sway_text_texture *text, void *user);
+
+/**
+ * Returns the texture to render, or NULL if text is NULL or renders to
+ * nothing.
+ */
+struct wlr_texture *text_texture_get_texture(struct sway_text_texture *text);
+
+void text_texture_cache_get_stats(struct sway_text_texture_stats *stats);
+
+/**
+ * Destroy all cached textures which are no longer referenced.
+ */
+void text_texture_cache_clear(void);
+
+#endif
@@ -8,6 +8,7 @@
 
 struct sway_view;
 struct sway_seat;
+struct sway_text_texture;
 
 enum sway_container_layout {
 	L_NONE,
@@ -71,6 +72,11 @@ struct sway_container {
 	struct sway_container_state current;
 	struct sway_container_state pending;
 
+	// The pending state as it was last added to a transaction. Arranging
+	// compares against it, so containers whose geometry came out the same
+	// aren't marked dirty again.
+	struct sway_container_state transacted;
+
 	char *title;           // The view's title (unformatted)
 	char *formatted_title; // The title displayed in the title bar
 
@@ -87,6 +93,12 @@ struct sway_container {
 	double saved_x, saved_y;
 	double saved_width, saved_height;
 
+	// The box the container was last arranged in. Arranging its parent skips
+	// the container if its new box is the same and its node isn't
+	// layout_dirty.
+	double arranged_x, arranged_y;
+	double arranged_width, arranged_height;
+
 	// Used when the view changes to CSD unexpectedly. This will be a non-B_CSD
 	// border which we use to restore when the view returns to SSD.
 	enum sway_container_border saved_border;
@@ -115,18 +127,18 @@ struct sway_container {
 
 	float alpha;
 
-	struct wlr_texture *title_focused;
-	struct wlr_texture *title_focused_inactive;
-	struct wlr_texture *title_unfocused;
-	struct wlr_texture *title_urgent;
+	struct sway_text_texture *title_focused;
+	struct sway_text_texture *title_focused_inactive;
+	struct sway_text_texture *title_unfocused;
+	struct sway_text_texture *title_urgent;
 	size_t title_height;
 	size_t title_baseline;
 
 	list_t *marks; // char *
-	struct wlr_texture *marks_focused;
-	struct wlr_texture *marks_focused_inactive;
-	struct wlr_texture *marks_unfocused;
-	struct wlr_texture *marks_urgent;
+	struct sway_text_texture *marks_focused;
+	struct sway_text_texture *marks_focused_inactive;
+	struct sway_text_texture *marks_unfocused;
+	struct sway_text_texture *marks_urgent;
 
 	struct {
 		struct wl_signal destroy;
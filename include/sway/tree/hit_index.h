@@ -0,0 +1,54 @@
+#ifndef _SWAY_HIT_INDEX_H
+#define _SWAY_HIT_INDEX_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct sway_container;
+struct sway_workspace;
+
+/**
+ * A part of the tiling layout which the pointer can hit.
+ */
+struct sway_hit_region {
+	double x1, y1, x2, y2; // In layout coordinates, x2 and y2 excluded
+	struct sway_container *con;
+	// Whether the region is the view of con. Otherwise it is the tab or stack
+	// title of con, which hits the container itself.
+	bool view;
+};
+
+/**
+ * A uniform grid over the tiling layout of a workspace, as it is currently
+ * rendered. Each cell lists the regions overlapping it in the order the tree
+ * would be searched, so a hit test only looks at a handful of regions.
+ *
+ * The index is invalidated whenever a transaction is applied and rebuilt on
+ * the next lookup.
+ */
+struct sway_hit_index {
+	bool valid;
+	double x, y; // Origin of the grid
+	int cols, rows;
+
+	struct sway_hit_region *regions;
+	size_t regions_len, regions_cap;
+
+	// Regions of cell i are cell_regions[cell_start[i]..cell_start[i + 1]]
+	uint32_t *cell_start;
+	uint32_t *cell_regions;
+	size_t cell_regions_cap;
+};
+
+void hit_index_invalidate(struct sway_hit_index *index);
+
+void hit_index_finish(struct sway_hit_index *index);
+
+/**
+ * Find the tiling region of the workspace at the given layout coordinates,
+ * rebuilding the index if needed. Returns NULL if there is none.
+ */
+const struct sway_hit_region *hit_index_lookup(struct sway_workspace *ws,
+		double lx, double ly);
+
+#endif
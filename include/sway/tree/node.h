@@ -20,6 +20,8 @@ enum sway_node_type {
 	N_CONTAINER,
 };
 
+struct ipc_json_fragment;
+
 struct sway_node {
 	enum sway_node_type type;
 	union {
@@ -43,6 +45,14 @@ struct sway_node {
 	// the current.
 	bool dirty;
 
+	// If true, the next arrange lays out all of the node's children again
+	// rather than skipping those whose box didn't change. Set on the node's
+	// ancestors too, so arranging them reaches it.
+	bool layout_dirty;
+
+	// The cached get_tree description of the node and its children
+	struct ipc_json_fragment *ipc_json;
+
 	struct {
 		struct wl_signal destroy;
 	} events;
@@ -58,6 +68,13 @@ const char *node_type_to_str(enum sway_node_type type);
  */
 void node_set_dirty(struct sway_node *node);
 
+/**
+ * Mark a node and its ancestors as needing to be arranged again, for changes
+ * arranging can't see from the node's box, such as its children, layout or
+ * border.
+ */
+void node_set_layout_dirty(struct sway_node *node);
+
 bool node_is_view(struct sway_node *node);
 
 char *node_get_name(struct sway_node *node);
@@ -7,6 +7,7 @@
 #include "sway/tree/container.h"
 #include "sway/tree/node.h"
 #include "config.h"
+#include "hash_table.h"
 #include "list.h"
 
 extern struct sway_root *root;
@@ -35,6 +36,17 @@ struct sway_root {
 
 	struct sway_container *fullscreen_global;
 
+	// Incremented whenever a container or workspace is moved in the tree, or
+	// becomes or stops being global fullscreen
+	size_t tree_serial;
+
+	// Lookup tables, which may still contain nodes being destroyed
+	hash_table_t *containers_by_id; // con_id -> struct sway_container
+	hash_table_t *marks; // mark -> struct sway_container
+	hash_table_t *workspaces_by_name; // lowercase name -> struct sway_workspace
+	// Leading digits of the name -> list_t of struct sway_workspace
+	hash_table_t *workspaces_by_number;
+
 	struct {
 		struct wl_signal new_node;
 	} events;
@@ -80,6 +92,12 @@ void root_for_each_workspace(void (*f)(struct sway_workspace *ws, void *data),
 void root_for_each_container(void (*f)(struct sway_container *con, void *data),
 		void *data);
 
+/**
+ * Mark every workspace and container as needing to be arranged again, for
+ * changes to the config which arranging doesn't track per node.
+ */
+void root_set_layout_dirty(void);
+
 struct sway_output *root_find_output(
 		bool (*test)(struct sway_output *output, void *data), void *data);
 
@@ -89,6 +107,17 @@ struct sway_workspace *root_find_workspace(
 struct sway_container *root_find_container(
 		bool (*test)(struct sway_container *con, void *data), void *data);
 
+/**
+ * Find a container in the tree by its con_id, without walking the tree.
+ */
+struct sway_container *root_find_container_by_id(size_t id);
+
+/**
+ * Whether a container is visited by root_for_each_container, ie. it isn't
+ * being destroyed and is either on a workspace or hidden in the scratchpad.
+ */
+bool root_has_container(struct sway_container *con);
+
 void root_get_box(struct sway_root *root, struct wlr_box *box);
 
 void root_rename_pid_workspaces(const char *old_name, const char *new_name);
@@ -87,6 +87,12 @@ struct sway_view {
 	bool allow_request_urgent;
 	struct wl_event_source *urgent_timer;
 
+	// Title changes requested by the client are coalesced and applied right
+	// before the next frame, see view_request_title_update
+	bool title_dirty;
+	struct timespec title_updated; // When the title last changed
+	struct wl_event_source *title_timer; // Waiting for max_title_update_rate
+
 	struct wl_list saved_buffers; // sway_saved_buffer::link
 
 	// The geometry for whatever the client is committing, regardless of
@@ -97,6 +103,18 @@ struct sway_view {
 	// when a transaction is applied.
 	struct wlr_box saved_geometry;
 
+	// A configure which its transaction timed out waiting for. Its latency is
+	// still measured when the client acks it, or when it is superseded.
+	bool late_configure;
+	uint32_t late_configure_serial;
+	struct wlr_box late_configure_geometry;
+	struct timespec late_configure_time; // When it was sent
+	uint32_t late_configure_timeout_ms; // Waited for it before giving up
+
+	// In the views of a client whose configure latency is in their cached IPC
+	// description, see transaction_get_view_latency
+	struct wl_list latency_link;
+
 	struct wlr_foreign_toplevel_handle_v1 *foreign_toplevel;
 	struct wl_listener foreign_activate_request;
 	struct wl_listener foreign_fullscreen_request;
@@ -341,6 +359,18 @@ struct sway_view *view_from_wlr_surface(struct wlr_surface *surface);
  */
 void view_update_title(struct sway_view *view, bool force);
 
+/**
+ * Schedule a title update for a client title change. Updates are applied at
+ * most once per frame, and no more often than max_title_update_rate.
+ */
+void view_request_title_update(struct sway_view *view);
+
+/**
+ * Apply the title updates scheduled by view_request_title_update. This is
+ * called right before rendering.
+ */
+void view_update_dirty_titles(void);
+
 /**
  * Run any criteria that match the view and haven't been run on this view
  * before.
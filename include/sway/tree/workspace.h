@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "sway/tree/container.h"
+#include "sway/tree/hit_index.h"
 #include "sway/tree/node.h"
 
 struct sway_view;
@@ -43,6 +44,11 @@ struct sway_workspace {
 	bool urgent;
 
 	struct sway_workspace_state current;
+
+	// The state as it was last added to a transaction
+	struct sway_workspace_state transacted;
+
+	struct sway_hit_index hit_index; // Of the current tiling layout
 };
 
 struct workspace_config *workspace_find_config(const char *ws_name);
@@ -67,6 +73,11 @@ bool workspace_switch(struct sway_workspace *workspace);
 
 struct sway_workspace *workspace_by_number(const char* name);
 
+/**
+ * Replace the name of the workspace, taking ownership of the new name.
+ */
+void workspace_set_name(struct sway_workspace *ws, char *name);
+
 struct sway_workspace *workspace_by_name(const char*);
 
 struct sway_workspace *workspace_output_next(struct sway_workspace *current);
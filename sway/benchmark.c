@@ -0,0 +1,287 @@
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wayland-server-core.h>
+#include "log.h"
+#include "sway/benchmark.h"
+#include "sway/desktop/frame_stats.h"
+#include "sway/desktop/transaction.h"
+#include "sway/output.h"
+#include "sway/server.h"
+#include "sway/tree/arrange.h"
+#include "sway/tree/container.h"
+#include "sway/tree/root.h"
+#include "sway/tree/workspace.h"
+
+void sway_terminate(int exit_code);
+
+// How often to check whether the windows have settled, in milliseconds
+#define SETTLE_INTERVAL 250
+// How many checks without new windows before starting
+#define SETTLE_CHECKS 4
+
+enum benchmark_layout {
+	BENCHMARK_SPLIT,
+	BENCHMARK_TABBED,
+	BENCHMARK_STACKED,
+	BENCHMARK_FLOATING,
+	BENCHMARK_LAYOUT_COUNT,
+};
+
+static const char *layout_names[] = {
+	[BENCHMARK_SPLIT] = "split",
+	[BENCHMARK_TABBED] = "tabbed",
+	[BENCHMARK_STACKED] = "stacked",
+	[BENCHMARK_FLOATING] = "floating",
+};
+
+struct benchmark_result {
+	struct sway_histogram render_time;
+	struct sway_histogram arrange_time;
+	uint64_t frames;
+	uint64_t missed_frames;
+};
+
+static struct {
+	bool running;
+	int frames; // Per layout
+	int views;
+
+	struct wl_event_source *settle_timer;
+	int last_views;
+	int settle_checks;
+
+	enum benchmark_layout layout;
+	uint64_t frame; // Selects the scripted damage
+	uint64_t frames_start, missed_frames_start;
+	struct sway_histogram render_time_start;
+
+	struct benchmark_result results[BENCHMARK_LAYOUT_COUNT];
+} benchmark;
+
+static void count_view(struct sway_container *con, void *data) {
+	int *views = data;
+	if (con->view) {
+		++*views;
+	}
+}
+
+/**
+ * Sum the frame stats of all outputs.
+ */
+static void get_frame_stats(struct sway_histogram *render_time,
+		uint64_t *frames, uint64_t *missed_frames) {
+	memset(render_time, 0, sizeof(*render_time));
+	*frames = *missed_frames = 0;
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		struct sway_frame_stats *stats = &output->frame_stats;
+		for (int j = 0; j < HISTOGRAM_BUCKETS; ++j) {
+			render_time->buckets[j] += stats->render_time.buckets[j];
+		}
+		render_time->count += stats->render_time.count;
+		*frames += stats->frames;
+		*missed_frames += stats->missed_frames;
+	}
+}
+
+static void set_split_layout(struct sway_container *con, void *data) {
+	enum sway_container_layout *layout = data;
+	if (!con->view) {
+		con->pending.layout = *layout;
+	}
+	con->node.layout_dirty = true;
+}
+
+static void apply_layout(enum benchmark_layout layout) {
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		struct sway_workspace *ws = output_get_active_workspace(output);
+		if (!ws) {
+			continue;
+		}
+		if (layout == BENCHMARK_FLOATING) {
+			while (ws->tiling->length) {
+				container_set_floating(ws->tiling->items[0], true);
+			}
+		} else {
+			enum sway_container_layout con_layout =
+				layout == BENCHMARK_TABBED ? L_TABBED :
+				layout == BENCHMARK_STACKED ? L_STACKED : L_HORIZ;
+			ws->layout = con_layout;
+			ws->node.layout_dirty = true;
+			workspace_for_each_container(ws, set_split_layout, &con_layout);
+		}
+		arrange_workspace(ws);
+	}
+	transaction_commit_dirty();
+}
+
+static void start_layout(enum benchmark_layout layout) {
+	sway_log(SWAY_INFO, "Benchmarking %s layout", layout_names[layout]);
+	benchmark.layout = layout;
+	apply_layout(layout);
+	get_frame_stats(&benchmark.render_time_start, &benchmark.frames_start,
+		&benchmark.missed_frames_start);
+	for (int i = 0; i < root->outputs->length; ++i) {
+		output_damage_whole(root->outputs->items[i]);
+	}
+}
+
+static void print_histogram(const char *name,
+		const struct sway_histogram *histogram, bool last) {
+	printf("\t\t\t\"%s\": {\"count\": %" PRIu64 ", \"p50\": %" PRIu64
+		", \"p95\": %" PRIu64 ", \"p99\": %" PRIu64 "}%s\n", name,
+		histogram->count,
+		histogram_get_percentile(histogram, 50),
+		histogram_get_percentile(histogram, 95),
+		histogram_get_percentile(histogram, 99),
+		last ? "" : ",");
+}
+
+static void print_results(void) {
+	printf("{\n");
+	printf("\t\"outputs\": %d,\n", root->outputs->length);
+	printf("\t\"views\": %d,\n", benchmark.views);
+	printf("\t\"layouts\": {\n");
+	for (int i = 0; i < BENCHMARK_LAYOUT_COUNT; ++i) {
+		struct benchmark_result *result = &benchmark.results[i];
+		printf("\t\t\"%s\": {\n", layout_names[i]);
+		printf("\t\t\t\"frames\": %" PRIu64 ",\n", result->frames);
+		printf("\t\t\t\"missed_frames\": %" PRIu64 ",\n",
+			result->missed_frames);
+		print_histogram("render_time", &result->render_time, false);
+		print_histogram("arrange_time", &result->arrange_time, true);
+		printf("\t\t}%s\n", i == BENCHMARK_LAYOUT_COUNT - 1 ? "" : ",");
+	}
+	printf("\t}\n");
+	printf("}\n");
+	fflush(stdout);
+}
+
+static void finish_layout(void) {
+	struct benchmark_result *result = &benchmark.results[benchmark.layout];
+	uint64_t frames, missed_frames;
+	get_frame_stats(&result->render_time, &frames, &missed_frames);
+	for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		result->render_time.buckets[i] -=
+			benchmark.render_time_start.buckets[i];
+	}
+	result->render_time.count -= benchmark.render_time_start.count;
+	result->frames = frames - benchmark.frames_start;
+	result->missed_frames = missed_frames - benchmark.missed_frames_start;
+
+	if (benchmark.layout + 1 < BENCHMARK_LAYOUT_COUNT) {
+		start_layout(benchmark.layout + 1);
+		return;
+	}
+
+	benchmark.running = false;
+	print_results();
+	sway_terminate(EXIT_SUCCESS);
+}
+
+/**
+ * Damage for the next frame. The patterns rotate between a full repaint,
+ * every window, a grid of small boxes like many small surfaces updating at
+ * once, and a single box like a blinking cursor.
+ */
+static void damage_output(struct sway_output *output) {
+	uint64_t frame = benchmark.frame++;
+	switch (frame % 4) {
+	case 0:
+		output_damage_whole(output);
+		break;
+	case 1: {
+		struct sway_workspace *ws = output->current.active_workspace;
+		for (int i = 0; ws && i < ws->current.tiling->length; ++i) {
+			output_damage_whole_container(output,
+				ws->current.tiling->items[i]);
+		}
+		for (int i = 0; ws && i < ws->current.floating->length; ++i) {
+			output_damage_whole_container(output,
+				ws->current.floating->items[i]);
+		}
+		break;
+	}
+	case 2:
+		for (int y = 0; y < 8; ++y) {
+			for (int x = 0; x < 8; ++x) {
+				struct wlr_box box = {
+					.x = output->lx + (x * 2 + 1) * output->width / 16,
+					.y = output->ly + (y * 2 + 1) * output->height / 16,
+					.width = 16,
+					.height = 16,
+				};
+				output_damage_box(output, &box);
+			}
+		}
+		break;
+	case 3: {
+		struct wlr_box box = {
+			.x = output->lx + output->width / 2,
+			.y = output->ly + output->height / 2,
+			.width = 10,
+			.height = 20,
+		};
+		output_damage_box(output, &box);
+		break;
+	}
+	}
+}
+
+void benchmark_handle_frame(struct sway_output *output) {
+	if (!benchmark.running) {
+		return;
+	}
+
+	struct benchmark_result *result = &benchmark.results[benchmark.layout];
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	arrange_root();
+	transaction_commit_dirty();
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	histogram_add(&result->arrange_time, timespec_diff_usec(&start, &end));
+
+	damage_output(output);
+
+	uint64_t frames = 0;
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *o = root->outputs->items[i];
+		frames += o->frame_stats.frames;
+	}
+	if (frames - benchmark.frames_start >=
+			(uint64_t)benchmark.frames * root->outputs->length) {
+		finish_layout();
+	}
+}
+
+static int handle_settle_timer(void *data) {
+	int views = 0;
+	root_for_each_container(count_view, &views);
+	if (views != benchmark.last_views || root->outputs->length == 0) {
+		benchmark.last_views = views;
+		benchmark.settle_checks = 0;
+	} else if (++benchmark.settle_checks >= SETTLE_CHECKS) {
+		wl_event_source_remove(benchmark.settle_timer);
+		benchmark.settle_timer = NULL;
+		benchmark.views = views;
+		benchmark.running = true;
+		start_layout(BENCHMARK_SPLIT);
+		return 0;
+	}
+	wl_event_source_timer_update(benchmark.settle_timer, SETTLE_INTERVAL);
+	return 0;
+}
+
+void benchmark_start(int frames) {
+	sway_log(SWAY_INFO, "Waiting for windows to settle before benchmarking");
+	benchmark.frames = frames;
+	benchmark.last_views = -1;
+	benchmark.settle_timer = wl_event_loop_add_timer(server.wl_event_loop,
+		handle_settle_timer, NULL);
+	wl_event_source_timer_update(benchmark.settle_timer, SETTLE_INTERVAL);
+}
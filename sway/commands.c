@@ -75,6 +75,8 @@ static const struct cmd_handler handlers[] = {
 	{ "gaps", cmd_gaps },
 	{ "hide_edge_borders", cmd_hide_edge_borders },
 	{ "input", cmd_input },
+	{ "ipc_max_queued_bytes", cmd_ipc_max_queued_bytes },
+	{ "max_title_update_rate", cmd_max_title_update_rate },
 	{ "mode", cmd_mode },
 	{ "mouse_warping", cmd_mouse_warping },
 	{ "new_float", cmd_new_float },
@@ -95,6 +95,7 @@ struct cmd_results *cmd_border(int argc, char **argv) {
 		container_set_geometry_from_content(container);
 	}
 
+	node_set_layout_dirty(&container->node);
 	arrange_container(container);
 
 	return cmd_results_new(CMD_SUCCESS, NULL);
@@ -129,6 +129,7 @@ static void configure_gaps(struct sway_workspace *ws, void *_data) {
 		ws->gaps_inner = 0;
 	}
 	prevent_invalid_outer_gaps();
+	node_set_layout_dirty(&ws->node);
 	arrange_workspace(ws);
 }
 
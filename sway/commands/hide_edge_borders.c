@@ -42,6 +42,7 @@ struct cmd_results *cmd_hide_edge_borders(int argc, char **argv) {
 	}
 	config->hide_lone_tab = hide_lone_tab;
 
+	root_set_layout_dirty();
 	arrange_root();
 
 	return cmd_results_new(CMD_SUCCESS, NULL);
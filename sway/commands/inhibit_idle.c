@@ -2,6 +2,7 @@
 #include "sway/commands.h"
 #include "sway/config.h"
 #include "sway/desktop/idle_inhibit_v1.h"
+#include "sway/ipc-json.h"
 #include "sway/tree/container.h"
 #include "sway/tree/view.h"
 
@@ -41,6 +42,7 @@ struct cmd_results *cmd_inhibit_idle(int argc, char **argv) {
 			sway_idle_inhibit_v1_user_inhibitor_destroy(inhibitor);
 		} else {
 			inhibitor->mode = mode;
+			ipc_json_invalidate_all();
 			sway_idle_inhibit_v1_check_active(server.idle_inhibit_manager_v1);
 		}
 	} else if (!clear) {
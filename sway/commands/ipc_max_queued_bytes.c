@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+
+struct cmd_results *cmd_ipc_max_queued_bytes(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "ipc_max_queued_bytes", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+
+	char *end;
+	unsigned long long bytes = strtoull(argv[0], &end, 10);
+	size_t unit = 1;
+	if (strcasecmp(end, "K") == 0) {
+		unit = 1024;
+	} else if (strcasecmp(end, "M") == 0) {
+		unit = 1024 * 1024;
+	} else if (*end) {
+		bytes = 0;
+	}
+	if (argv[0][0] == '-' || bytes == 0 || bytes > SIZE_MAX / unit) {
+		return cmd_results_new(CMD_INVALID,
+			"Invalid size: expected a positive number of bytes, "
+			"optionally followed by K or M");
+	}
+
+	config->ipc_max_queued_bytes = bytes * unit;
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -175,6 +175,8 @@ struct cmd_results *cmd_layout(int argc, char **argv) {
 			workspace->layout = new_layout;
 			workspace_update_representation(workspace);
 		}
+		node_set_layout_dirty(container ?
+			&container->node : &workspace->node);
 		if (root->fullscreen_global) {
 			arrange_root();
 		} else {
@@ -0,0 +1,27 @@
+#include <stdlib.h>
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+
+struct cmd_results *cmd_max_title_update_rate(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "max_title_update_rate", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+
+	int rate;
+	if (strcasecmp(argv[0], "off") == 0) {
+		rate = 0;
+	} else {
+		char *end;
+		rate = strtol(argv[0], &end, 10);
+		if (*end || rate <= 0) {
+			return cmd_results_new(CMD_INVALID,
+				"Invalid rate: expected 'off' or a positive number of "
+				"updates per second");
+		}
+	}
+
+	config->max_title_update_rate = rate;
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -121,6 +121,7 @@ static void container_move_to_container_from_direction(
 			int destination_index = list_find(siblings, destination);
 			list_swap(siblings, container_index, destination_index);
 			container_update_representation(container);
+			node_set_layout_dirty(node_get_parent(&container->node));
 		} else {
 			sway_log(SWAY_DEBUG, "Promoting to sibling of cousin");
 			int offset =
@@ -51,6 +51,7 @@ static void do_reload(void *data) {
 	config_update_font_height(true);
 	root_for_each_container(rebuild_textures_iterator, NULL);
 
+	root_set_layout_dirty();
 	arrange_root();
 }
 
@@ -178,6 +178,7 @@ void container_resize_tiled(struct sway_container *con,
 		}
 	}
 
+	node_set_layout_dirty(node_get_parent(&con->node));
 	if (con->pending.parent) {
 		arrange_container(con->pending.parent);
 	} else {
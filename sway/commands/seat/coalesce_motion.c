@@ -0,0 +1,23 @@
+#include <string.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "util.h"
+
+struct cmd_results *seat_cmd_coalesce_motion(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "coalesce_motion", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+	if (!config->handler_context.seat_config) {
+		return cmd_results_new(CMD_INVALID, "No seat defined");
+	}
+
+	struct seat_config *seat_config = config->handler_context.seat_config;
+	if (parse_boolean(argv[0], false)) {
+		seat_config->coalesce_motion = COALESCE_MOTION_ENABLE;
+	} else {
+		seat_config->coalesce_motion = COALESCE_MOTION_DISABLE;
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
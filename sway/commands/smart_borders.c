@@ -17,6 +17,7 @@ struct cmd_results *cmd_smart_borders(int argc, char **argv) {
 			ESMART_ON : ESMART_OFF;
 	}
 
+	root_set_layout_dirty();
 	arrange_root();
 
 	return cmd_results_new(CMD_SUCCESS, NULL);
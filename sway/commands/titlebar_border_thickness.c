@@ -19,6 +19,7 @@ struct cmd_results *cmd_titlebar_border_thickness(int argc, char **argv) {
 
 	config->titlebar_border_thickness = value;
 
+	root_set_layout_dirty();
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
 		struct sway_workspace *ws = output_get_active_workspace(output);
@@ -30,6 +30,7 @@ struct cmd_results *cmd_titlebar_padding(int argc, char **argv) {
 	config->titlebar_v_padding = v_value;
 	config->titlebar_h_padding = h_value;
 
+	root_set_layout_dirty();
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
 		arrange_workspace(output_get_active_workspace(output));
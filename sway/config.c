@@ -238,6 +238,8 @@ static void config_defaults(struct sway_config *config) {
 	if (!(config->font = strdup("monospace 10"))) goto cleanup;
 	config->font_height = 17; // height of monospace 10
 	config->urgent_timeout = 500;
+	config->max_title_update_rate = 0;
+	config->ipc_max_queued_bytes = 4 * 1024 * 1024;
 	config->focus_on_window_activation = FOWA_URGENT;
 	config->popup_during_fullscreen = POPUP_SMART;
 	config->xwayland = XWAYLAND_MODE_LAZY;
@@ -1016,6 +1018,7 @@ void config_update_font_height(bool recalculate) {
 	root_for_each_container(find_font_height_iterator, NULL);
 
 	if (config->font_height != prev_max_height) {
+		root_set_layout_dirty();
 		arrange_root();
 	}
 }
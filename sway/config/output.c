@@ -473,9 +473,17 @@ bool apply_output_config(struct output_config *oc, struct sway_output *output) {
 		output_enable(output);
 	}
 
-	if (oc && oc->max_render_time >= 0) {
+	if (oc && oc->max_render_time == MAX_RENDER_TIME_AUTO) {
+		sway_log(SWAY_DEBUG, "Set %s max render time to auto", oc->name);
+		if (!output->max_render_time_auto) {
+			render_time_auto_reset(&output->render_time_auto);
+		}
+		output->max_render_time_auto = true;
+		output->max_render_time = 0;
+	} else if (oc && oc->max_render_time >= 0) {
 		sway_log(SWAY_DEBUG, "Set %s max render time to %d",
 			oc->name, oc->max_render_time);
+		output->max_render_time_auto = false;
 		output->max_render_time = oc->max_render_time;
 	}
 
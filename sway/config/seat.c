@@ -31,6 +31,7 @@ struct seat_config *new_seat_config(const char* name) {
 	seat->hide_cursor_timeout = -1;
 	seat->hide_cursor_when_typing = HIDE_WHEN_TYPING_DEFAULT;
 	seat->allow_constrain = CONSTRAIN_DEFAULT;
+	seat->coalesce_motion = COALESCE_MOTION_DEFAULT;
 	seat->shortcuts_inhibit = SHORTCUTS_INHIBIT_DEFAULT;
 	seat->keyboard_grouping = KEYBOARD_GROUP_DEFAULT;
 	seat->xcursor_theme.name = NULL;
@@ -160,6 +161,10 @@ void merge_seat_config(struct seat_config *dest, struct seat_config *source) {
 		dest->allow_constrain = source->allow_constrain;
 	}
 
+	if (source->coalesce_motion != COALESCE_MOTION_DEFAULT) {
+		dest->coalesce_motion = source->coalesce_motion;
+	}
+
 	if (source->shortcuts_inhibit != SHORTCUTS_INHIBIT_DEFAULT) {
 		dest->shortcuts_inhibit = source->shortcuts_inhibit;
 	}
@@ -461,6 +461,15 @@ list_t *criteria_get_containers(struct criteria *criteria) {
 		.criteria = criteria,
 		.matches = matches,
 	};
+	if (criteria->con_id) {
+		// At most one container can match, so there's no need to walk the tree
+		struct sway_container *con =
+			root_find_container_by_id(criteria->con_id);
+		if (con) {
+			criteria_get_containers_iterator(con, &data);
+		}
+		return matches;
+	}
 	root_for_each_container(criteria_get_containers_iterator, &data);
 	return matches;
 }
@@ -0,0 +1,177 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sway/desktop/frame_stats.h"
+
+#define SUB_BUCKETS_SHIFT 2 // Four buckets per power of two
+#define SUB_BUCKETS (1 << SUB_BUCKETS_SHIFT)
+
+// Frames measured before max_render_time auto starts delaying rendering
+#define RENDER_TIME_MIN_SAMPLES 16
+// How often max_render_time auto is recomputed, in frames
+#define RENDER_TIME_UPDATE_FRAMES 16
+// How long a back-off after a missed frame lasts, in frames
+#define RENDER_TIME_BACKOFF_FRAMES 600
+
+static int bucket_index(uint64_t usec) {
+	if (usec < SUB_BUCKETS) {
+		return usec;
+	}
+	int msb = 63 - __builtin_clzll(usec);
+	int sub = (usec >> (msb - SUB_BUCKETS_SHIFT)) & (SUB_BUCKETS - 1);
+	int index = (msb - SUB_BUCKETS_SHIFT + 1) * SUB_BUCKETS + sub;
+	return index < HISTOGRAM_BUCKETS ? index : HISTOGRAM_BUCKETS - 1;
+}
+
+static uint64_t bucket_upper_bound(int index) {
+	if (index < SUB_BUCKETS) {
+		return index;
+	}
+	int shift = index / SUB_BUCKETS - 1;
+	int sub = index % SUB_BUCKETS;
+	return ((uint64_t)(SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void histogram_add(struct sway_histogram *histogram, uint64_t usec) {
+	histogram->buckets[bucket_index(usec)]++;
+	histogram->count++;
+}
+
+uint64_t histogram_get_percentile(const struct sway_histogram *histogram,
+		double percentile) {
+	if (histogram->count == 0) {
+		return 0;
+	}
+	uint64_t rank = histogram->count * percentile / 100.0;
+	if (rank >= histogram->count) {
+		rank = histogram->count - 1;
+	}
+	uint64_t seen = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		seen += histogram->buckets[i];
+		if (seen > rank) {
+			return bucket_upper_bound(i);
+		}
+	}
+	return bucket_upper_bound(HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t timespec_diff_usec(const struct timespec *start,
+		const struct timespec *end) {
+	int64_t nsec = (int64_t)(end->tv_sec - start->tv_sec) * 1000000000 +
+		(end->tv_nsec - start->tv_nsec);
+	return nsec > 0 ? nsec / 1000 : 0;
+}
+
+static bool timespec_is_set(const struct timespec *t) {
+	return t->tv_sec != 0 || t->tv_nsec != 0;
+}
+
+void frame_stats_handle_frame(struct sway_frame_stats *stats,
+		const struct timespec *when) {
+	stats->frame_event = *when;
+}
+
+void frame_stats_handle_commit(struct sway_frame_stats *stats,
+		const struct timespec *render_start, const struct timespec *render_end,
+		const struct timespec *when) {
+	stats->frames++;
+	histogram_add(&stats->render_time,
+		timespec_diff_usec(render_start, render_end));
+	if (timespec_is_set(&stats->frame_event)) {
+		histogram_add(&stats->damage_to_commit,
+			timespec_diff_usec(&stats->frame_event, when));
+	}
+	stats->committed_frame_event = stats->frame_event;
+	stats->frame_event = (struct timespec){0};
+}
+
+uint64_t frame_stats_handle_present(struct sway_frame_stats *stats,
+		const struct timespec *when, uint32_t refresh_nsec) {
+	uint64_t missed = 0;
+
+	// Only frames started right after the previous presentation count
+	// towards the interval; otherwise the output was just idle.
+	const struct timespec *frame = &stats->committed_frame_event;
+	if (timespec_is_set(frame) && timespec_is_set(&stats->last_present) &&
+			refresh_nsec > 0 &&
+			timespec_diff_usec(&stats->last_present, frame) * 1000 <
+				refresh_nsec) {
+		uint64_t interval = timespec_diff_usec(&stats->last_present, when);
+		histogram_add(&stats->present_interval, interval);
+
+		uint64_t refresh_usec = refresh_nsec / 1000;
+		uint64_t cycles = (interval + refresh_usec / 2) / refresh_usec;
+		if (cycles > 1) {
+			missed = cycles - 1;
+			stats->missed_frames += missed;
+		}
+	}
+	stats->committed_frame_event = (struct timespec){0};
+	stats->last_present = *when;
+	return missed;
+}
+
+void render_time_auto_reset(struct sway_render_time_auto *tuner) {
+	memset(tuner, 0, sizeof(*tuner));
+}
+
+void render_time_auto_add_sample(struct sway_render_time_auto *tuner,
+		uint64_t usec) {
+	tuner->samples[tuner->next] = usec < UINT32_MAX ? usec : UINT32_MAX;
+	tuner->next = (tuner->next + 1) % RENDER_TIME_SAMPLES;
+	if (tuner->nsamples < RENDER_TIME_SAMPLES) {
+		tuner->nsamples++;
+	}
+	if (tuner->backoff_frames > 0) {
+		tuner->backoff_frames--;
+	}
+}
+
+void render_time_auto_handle_missed(struct sway_render_time_auto *tuner) {
+	if (tuner->msec == 0) {
+		// Already rendering as early as possible
+		return;
+	}
+	tuner->msec *= 2;
+	tuner->backoff_msec = tuner->msec;
+	tuner->backoff_frames = RENDER_TIME_BACKOFF_FRAMES;
+	tuner->frames_until_update = RENDER_TIME_UPDATE_FRAMES;
+}
+
+static int compare_samples(const void *a, const void *b) {
+	uint32_t sa = *(const uint32_t *)a, sb = *(const uint32_t *)b;
+	return sa < sb ? -1 : sa > sb;
+}
+
+static void render_time_auto_update(struct sway_render_time_auto *tuner) {
+	uint32_t sorted[RENDER_TIME_SAMPLES];
+	memcpy(sorted, tuner->samples, tuner->nsamples * sizeof(sorted[0]));
+	qsort(sorted, tuner->nsamples, sizeof(sorted[0]), compare_samples);
+
+	// The 99th percentile plus a margin of a quarter and a millisecond for
+	// the scheduling jitter of the repaint timer
+	uint64_t usec = sorted[tuner->nsamples * 99 / 100];
+	usec += usec / 4 + 1000;
+	tuner->msec = (usec + 999) / 1000;
+
+	if (tuner->backoff_frames > 0 && tuner->msec < tuner->backoff_msec) {
+		tuner->msec = tuner->backoff_msec;
+	}
+}
+
+int render_time_auto_get_msec(struct sway_render_time_auto *tuner,
+		uint32_t refresh_nsec) {
+	if (refresh_nsec == 0 || tuner->nsamples < RENDER_TIME_MIN_SAMPLES) {
+		return 0;
+	}
+	if (--tuner->frames_until_update <= 0) {
+		render_time_auto_update(tuner);
+		tuner->frames_until_update = RENDER_TIME_UPDATE_FRAMES;
+	}
+	// Delaying by a whole refresh cycle or more gains nothing
+	if ((uint64_t)tuner->msec * 1000000 >= refresh_nsec) {
+		return 0;
+	}
+	return tuner->msec;
+}
@@ -3,6 +3,7 @@
 #include "log.h"
 #include "sway/desktop/idle_inhibit_v1.h"
 #include "sway/input/seat.h"
+#include "sway/ipc-json.h"
 #include "sway/tree/container.h"
 #include "sway/tree/view.h"
 #include "sway/server.h"
@@ -12,6 +13,7 @@ static void destroy_inhibitor(struct sway_idle_inhibitor_v1 *inhibitor) {
 	wl_list_remove(&inhibitor->link);
 	wl_list_remove(&inhibitor->destroy.link);
 	sway_idle_inhibit_v1_check_active(inhibitor->manager);
+	ipc_json_invalidate_all();
 	free(inhibitor);
 }
 
@@ -43,6 +45,7 @@ void handle_idle_inhibitor_v1(struct wl_listener *listener, void *data) {
 	wl_signal_add(&wlr_inhibitor->events.destroy, &inhibitor->destroy);
 
 	sway_idle_inhibit_v1_check_active(manager);
+	ipc_json_invalidate_all();
 }
 
 void sway_idle_inhibit_v1_user_inhibitor_register(struct sway_view *view,
@@ -62,6 +65,7 @@ void sway_idle_inhibit_v1_user_inhibitor_register(struct sway_view *view,
 	wl_signal_add(&view->events.unmap, &inhibitor->destroy);
 
 	sway_idle_inhibit_v1_check_active(inhibitor->manager);
+	ipc_json_invalidate_all();
 }
 
 struct sway_idle_inhibitor_v1 *sway_idle_inhibit_v1_user_inhibitor_for_view(
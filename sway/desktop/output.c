@@ -15,6 +15,7 @@
 #include <wlr/util/region.h>
 #include "config.h"
 #include "log.h"
+#include "sway/benchmark.h"
 #include "sway/config.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
@@ -495,6 +496,9 @@ static int output_repaint_timer_handler(void *data) {
 
 	output->wlr_output->frame_pending = false;
 
+	// Rasterize the titles which changed since the last frame
+	view_update_dirty_titles();
+
 	struct sway_workspace *workspace = output->current.active_workspace;
 	if (workspace == NULL) {
 		return 0;
@@ -556,15 +560,27 @@ static void damage_handle_frame(struct wl_listener *listener, void *user_data) {
 		return;
 	}
 
+	clockid_t presentation_clock
+		= wlr_backend_get_presentation_clock(server.backend);
+	struct timespec frame_time;
+	clock_gettime(presentation_clock, &frame_time);
+	frame_stats_handle_frame(&output->frame_stats, &frame_time);
+
+	if (debug.benchmark_frames > 0) {
+		benchmark_handle_frame(output);
+	}
+
+	if (output->max_render_time_auto) {
+		output->max_render_time = render_time_auto_get_msec(
+			&output->render_time_auto, output->refresh_nsec);
+	}
+
 	// Compute predicted milliseconds until the next refresh. It's used for
 	// delaying both output rendering and surface frame callbacks.
 	int msec_until_refresh = 0;
 
 	if (output->max_render_time != 0) {
-		struct timespec now;
-		clockid_t presentation_clock
-			= wlr_backend_get_presentation_clock(server.backend);
-		clock_gettime(presentation_clock, &now);
+		struct timespec now = frame_time;
 
 		const long NSEC_IN_SECONDS = 1000000000;
 		struct timespec predicted_refresh = output->last_presentation;
@@ -829,6 +845,14 @@ static void handle_present(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	if (output_event->presented) {
+		uint64_t missed = frame_stats_handle_present(&output->frame_stats,
+			output_event->when, output_event->refresh);
+		if (missed && output->max_render_time_auto) {
+			render_time_auto_handle_missed(&output->render_time_auto);
+		}
+	}
+
 	output->last_presentation = *output_event->when;
 	output->refresh_nsec = output_event->refresh;
 }
@@ -1,7 +1,9 @@
 #define _POSIX_C_SOURCE 200809L
 #include <assert.h>
 #include <GLES2/gl2.h>
+#include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <time.h>
 #include <wayland-server-core.h>
@@ -22,6 +24,7 @@
 #include "sway/layers.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/text_texture.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
 #include "sway/tree/root.h"
@@ -50,10 +53,133 @@ static int scale_length(int length, int offset, float scale) {
 	return round((offset + length) * scale) - round(offset * scale);
 }
 
+// Every damage rectangle costs a scissor and a draw call for each surface in
+// it. Merging two rectangles is worth it if their bounding box covers less
+// than this many extra pixels.
+#define DAMAGE_RECT_COST (64 * 64)
+// How far ahead in the sorted rectangles to look for a merge candidate
+#define DAMAGE_MERGE_WINDOW 16
+// Damage with more rectangles than this is replaced by its extents
+#define DAMAGE_SIMPLIFY_MAX_INPUT 256
+
+static int64_t box_area(const pixman_box32_t *box) {
+	return (int64_t)(box->x2 - box->x1) * (box->y2 - box->y1);
+}
+
+static void box_union(pixman_box32_t *dest, const pixman_box32_t *a,
+		const pixman_box32_t *b) {
+	dest->x1 = a->x1 < b->x1 ? a->x1 : b->x1;
+	dest->y1 = a->y1 < b->y1 ? a->y1 : b->y1;
+	dest->x2 = a->x2 > b->x2 ? a->x2 : b->x2;
+	dest->y2 = a->y2 > b->y2 ? a->y2 : b->y2;
+}
+
+struct damage_merge_candidate {
+	int j; // The box to merge with, or -1 if there is none
+	int64_t cost;
+};
+
+/**
+ * Find the cheapest box to merge boxes[i] with among the next ones.
+ */
+static void find_merge_candidate(const pixman_box32_t *boxes, int nrects,
+		int i, struct damage_merge_candidate *candidate) {
+	candidate->j = -1;
+	candidate->cost = INT64_MAX;
+	int end = i + 1 + DAMAGE_MERGE_WINDOW;
+	for (int j = i + 1; j < nrects && j < end; ++j) {
+		pixman_box32_t merged;
+		box_union(&merged, &boxes[i], &boxes[j]);
+		int64_t cost = box_area(&merged) -
+			box_area(&boxes[i]) - box_area(&boxes[j]);
+		if (cost < candidate->cost) {
+			candidate->cost = cost;
+			candidate->j = j;
+		}
+	}
+}
+
+/**
+ * Greedily merge the rectangles of the damage which are cheaper to draw as
+ * one, and keep merging until there are at most max_rects of them. Returns
+ * false if the result is still over the limit.
+ */
+static bool merge_damage_rects(pixman_region32_t *damage, int max_rects) {
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(damage, &nrects);
+	if (nrects > DAMAGE_SIMPLIFY_MAX_INPUT) {
+		return false;
+	}
+	pixman_box32_t boxes[DAMAGE_SIMPLIFY_MAX_INPUT];
+	memcpy(boxes, rects, nrects * sizeof(pixman_box32_t));
+
+	// The boxes stay sorted by y1, so close boxes are close in the array.
+	// Each box keeps its best partner, and a merge only changes the partners
+	// of the boxes whose window held one of the merged boxes.
+	struct damage_merge_candidate candidates[DAMAGE_SIMPLIFY_MAX_INPUT];
+	for (int i = 0; i < nrects; ++i) {
+		find_merge_candidate(boxes, nrects, i, &candidates[i]);
+	}
+	while (nrects > 1) {
+		int best_i = 0;
+		for (int i = 1; i < nrects - 1; ++i) {
+			if (candidates[i].cost < candidates[best_i].cost) {
+				best_i = i;
+			}
+		}
+		int best_j = candidates[best_i].j;
+		if (nrects <= max_rects &&
+				candidates[best_i].cost > DAMAGE_RECT_COST) {
+			break;
+		}
+		box_union(&boxes[best_i], &boxes[best_i], &boxes[best_j]);
+		memmove(&boxes[best_j], &boxes[best_j + 1],
+			(nrects - best_j - 1) * sizeof(pixman_box32_t));
+		memmove(&candidates[best_j], &candidates[best_j + 1],
+			(nrects - best_j - 1) * sizeof(struct damage_merge_candidate));
+		nrects--;
+
+		// The boxes after best_j only moved down by one, with their windows
+		for (int i = best_j; i < nrects; ++i) {
+			if (candidates[i].j != -1) {
+				candidates[i].j--;
+			}
+		}
+		// The windows before best_j held a merged box or now reach one
+		// box further
+		int start = best_i - DAMAGE_MERGE_WINDOW;
+		for (int i = start > 0 ? start : 0; i < best_j; ++i) {
+			find_merge_candidate(boxes, nrects, i, &candidates[i]);
+		}
+	}
+
+	pixman_region32_fini(damage);
+	pixman_region32_init_rects(damage, boxes, nrects);
+	return pixman_region32_n_rects(damage) <= max_rects;
+}
+
+/**
+ * Bound the number of rectangles in the damage, at the cost of repainting
+ * some undamaged pixels. Merged boxes which overlap are split again by
+ * pixman, so this takes a few rounds and falls back to the extents.
+ */
+static void simplify_damage(pixman_region32_t *damage, int max_rects) {
+	for (int i = 0; i < 3; ++i) {
+		if (merge_damage_rects(damage, max_rects)) {
+			return;
+		}
+	}
+	pixman_box32_t extents = *pixman_region32_extents(damage);
+	pixman_region32_fini(damage);
+	pixman_region32_init_with_extents(damage, &extents);
+}
+
 static void scissor_output(struct wlr_output *wlr_output,
 		pixman_box32_t *rect) {
 	struct wlr_renderer *renderer = wlr_backend_get_renderer(wlr_output->backend);
 	assert(renderer);
+	struct sway_output *output = wlr_output->data;
+	output->render_stats.scissors++;
 
 	struct wlr_box box = {
 		.x = rect->x1,
@@ -212,6 +338,97 @@ static void render_drag_icons(struct sway_output *output,
 		render_surface_iterator, &data);
 }
 
+struct batched_rect {
+	struct wlr_box box; // output-buffer-local, already clipped to the damage
+	float color[4];
+};
+
+/**
+ * Solid color quads which are waiting to be drawn.
+ *
+ * Borders and titlebars are made of many small rectangles, and drawing each
+ * of them once per damage rectangle with its own scissor box is expensive.
+ * While batching, render_rect clips the rectangles against the damage on the
+ * CPU instead, merges adjacent pieces of the same color and defers drawing
+ * them until the batch is flushed, without touching the scissor box.
+ *
+ * The rectangles in a batch must not overlap anything else drawn between the
+ * batch's start and its flush, as they end up on top of it.
+ */
+static struct {
+	struct sway_output *output; // NULL when not batching
+	struct batched_rect *rects;
+	size_t length, capacity;
+} rect_batch;
+
+static void rect_batch_begin(struct sway_output *output) {
+	if (debug.norectbatch) {
+		return;
+	}
+	rect_batch.output = output;
+	rect_batch.length = 0;
+}
+
+static void rect_batch_flush(void) {
+	struct sway_output *output = rect_batch.output;
+	if (!output || rect_batch.length == 0) {
+		return;
+	}
+	struct wlr_output *wlr_output = output->wlr_output;
+	struct wlr_renderer *renderer =
+		wlr_backend_get_renderer(wlr_output->backend);
+
+	wlr_renderer_scissor(renderer, NULL);
+	for (size_t i = 0; i < rect_batch.length; ++i) {
+		struct batched_rect *rect = &rect_batch.rects[i];
+		wlr_render_rect(renderer, &rect->box, rect->color,
+			wlr_output->transform_matrix);
+	}
+	output->render_stats.rect_draws += rect_batch.length;
+	rect_batch.length = 0;
+}
+
+static void rect_batch_end(void) {
+	rect_batch_flush();
+	rect_batch.output = NULL;
+}
+
+static void rect_batch_add(const struct wlr_box *box,
+		const float color[static 4]) {
+	if (rect_batch.length > 0) {
+		// Damage rectangles are banded, so a rectangle which spans several
+		// bands gets split into pieces which can be joined back together
+		struct batched_rect *last = &rect_batch.rects[rect_batch.length - 1];
+		if (memcmp(last->color, color, sizeof(last->color)) == 0) {
+			if (last->box.x == box->x && last->box.width == box->width &&
+					last->box.y + last->box.height == box->y) {
+				last->box.height += box->height;
+				return;
+			}
+			if (last->box.y == box->y && last->box.height == box->height &&
+					last->box.x + last->box.width == box->x) {
+				last->box.width += box->width;
+				return;
+			}
+		}
+	}
+
+	if (rect_batch.length == rect_batch.capacity) {
+		size_t capacity = rect_batch.capacity ? rect_batch.capacity * 2 : 64;
+		struct batched_rect *rects = realloc(rect_batch.rects,
+			capacity * sizeof(struct batched_rect));
+		if (!sway_assert(rects, "Unable to grow rectangle batch")) {
+			return;
+		}
+		rect_batch.rects = rects;
+		rect_batch.capacity = capacity;
+	}
+
+	struct batched_rect *rect = &rect_batch.rects[rect_batch.length++];
+	rect->box = *box;
+	memcpy(rect->color, color, sizeof(rect->color));
+}
+
 // _box.x and .y are expected to be layout-local
 // _box.width and .height are expected to be output-buffer-local
 void render_rect(struct sway_output *output,
@@ -238,11 +455,25 @@ void render_rect(struct sway_output *output,
 
 	int nrects;
 	pixman_box32_t *rects = pixman_region32_rectangles(&damage, &nrects);
+	if (rect_batch.output == output) {
+		for (int i = 0; i < nrects; ++i) {
+			struct wlr_box clipped = {
+				.x = rects[i].x1,
+				.y = rects[i].y1,
+				.width = rects[i].x2 - rects[i].x1,
+				.height = rects[i].y2 - rects[i].y1,
+			};
+			rect_batch_add(&clipped, color);
+		}
+		goto damage_finish;
+	}
+
 	for (int i = 0; i < nrects; ++i) {
 		scissor_output(wlr_output, &rects[i]);
 		wlr_render_rect(renderer, &box, color,
 			wlr_output->transform_matrix);
 	}
+	output->render_stats.rect_draws += nrects;
 
 damage_finish:
 	pixman_region32_fini(&damage);
@@ -703,108 +934,179 @@ static void render_top_border(struct sway_output *output,
 	render_rect(output, output_damage, &box, color);
 }
 
+enum render_op_type {
+	RENDER_OP_TITLEBAR,        // Titlebar of a container
+	RENDER_OP_TOP_BORDER,      // Top border of a view using "border pixel"
+	RENDER_OP_VIEW,            // View surface and left/right/bottom borders
+	RENDER_OP_FULLSCREEN_VIEW, // Fullscreen view surface without borders
+};
+
+enum render_op_class {
+	RENDER_CLASS_FOCUSED,
+	RENDER_CLASS_FOCUSED_INACTIVE,
+	RENDER_CLASS_UNFOCUSED,
+};
+
+struct render_op {
+	enum render_op_type type;
+	// Urgency is resolved when replaying, as it can change without a
+	// transaction
+	enum render_op_class class;
+	struct sway_container *con;
+	int x, y, width; // Titlebar position in layout coordinates
+	int floater; // Index into render_list::floaters, or -1 if tiling
+};
+
+/**
+ * A flattened list of everything which has to be drawn for the tiling layout
+ * and the floating containers of an output, in render order.
+ *
+ * The list only depends on the current state of the tree, so it is built on
+ * the first frame after a transaction has been applied and then replayed
+ * against the damage of each frame. Anything which can change without a
+ * transaction (textures, urgency, opacity) is looked up when replaying.
+ */
+struct render_list {
+	struct render_op *ops;
+	size_t length, capacity;
+
+	list_t *floaters; // struct sway_container, in render order
+
+	// The state the list was built for
+	struct sway_workspace *workspace;
+	struct sway_container *fullscreen;
+};
+
+static void render_list_add(struct render_list *list,
+		const struct render_op *op) {
+	if (list->length == list->capacity) {
+		size_t capacity = list->capacity ? list->capacity * 2 : 32;
+		struct render_op *ops =
+			realloc(list->ops, capacity * sizeof(struct render_op));
+		if (!sway_assert(ops, "Unable to grow render list")) {
+			return;
+		}
+		list->ops = ops;
+		list->capacity = capacity;
+	}
+	list->ops[list->length++] = *op;
+}
+
+static enum render_op_class get_render_op_class(bool focused, bool active) {
+	if (focused) {
+		return RENDER_CLASS_FOCUSED;
+	} else if (active) {
+		return RENDER_CLASS_FOCUSED_INACTIVE;
+	}
+	return RENDER_CLASS_UNFOCUSED;
+}
+
 struct parent_data {
 	enum sway_container_layout layout;
 	struct wlr_box box;
 	list_t *children;
 	bool focused;
 	struct sway_container *active_child;
+	int floater;
 };
 
-static void render_container(struct sway_output *output,
-	pixman_region32_t *damage, struct sway_container *con, bool parent_focused);
+static void build_container(struct render_list *list,
+		struct sway_container *con, bool parent_focused, int floater);
+
+/**
+ * Add a view along with its titlebar or top border.
+ */
+static void build_view(struct render_list *list, struct sway_container *con,
+		enum render_op_class class, int floater) {
+	struct sway_container_state *state = &con->current;
+	if (state->border == B_NORMAL) {
+		render_list_add(list, &(struct render_op){
+			.type = RENDER_OP_TITLEBAR,
+			.class = class,
+			.con = con,
+			.x = floor(state->x),
+			.y = floor(state->y),
+			.width = state->width,
+			.floater = floater,
+		});
+	} else if (state->border == B_PIXEL) {
+		render_list_add(list, &(struct render_op){
+			.type = RENDER_OP_TOP_BORDER,
+			.class = class,
+			.con = con,
+			.floater = floater,
+		});
+	}
+	render_list_add(list, &(struct render_op){
+		.type = RENDER_OP_VIEW,
+		.class = class,
+		.con = con,
+		.floater = floater,
+	});
+}
 
 /**
- * Render a container's children using a L_HORIZ or L_VERT layout.
+ * Build a container's children using a L_HORIZ or L_VERT layout.
  *
  * Wrap child views in borders and leave child containers borderless because
  * they'll apply their own borders to their children.
  */
-static void render_containers_linear(struct sway_output *output,
-		pixman_region32_t *damage, struct parent_data *parent) {
+static void build_containers_linear(struct render_list *list,
+		struct parent_data *parent) {
 	for (int i = 0; i < parent->children->length; ++i) {
 		struct sway_container *child = parent->children->items[i];
 
 		if (child->view) {
-			struct sway_view *view = child->view;
-			struct border_colors *colors;
-			struct wlr_texture *title_texture;
-			struct wlr_texture *marks_texture;
-			struct sway_container_state *state = &child->current;
-
-			if (view_is_urgent(view)) {
-				colors = &config->border_colors.urgent;
-				title_texture = child->title_urgent;
-				marks_texture = child->marks_urgent;
-			} else if (state->focused || parent->focused) {
-				colors = &config->border_colors.focused;
-				title_texture = child->title_focused;
-				marks_texture = child->marks_focused;
-			} else if (child == parent->active_child) {
-				colors = &config->border_colors.focused_inactive;
-				title_texture = child->title_focused_inactive;
-				marks_texture = child->marks_focused_inactive;
-			} else {
-				colors = &config->border_colors.unfocused;
-				title_texture = child->title_unfocused;
-				marks_texture = child->marks_unfocused;
-			}
-
-			if (state->border == B_NORMAL) {
-				render_titlebar(output, damage, child, floor(state->x),
-						floor(state->y), state->width, colors,
-						title_texture, marks_texture);
-			} else if (state->border == B_PIXEL) {
-				render_top_border(output, damage, child, colors);
-			}
-			render_view(output, damage, child, colors);
+			enum render_op_class class = get_render_op_class(
+				child->current.focused || parent->focused,
+				child == parent->active_child);
+			build_view(list, child, class, parent->floater);
 		} else {
-			render_container(output, damage, child,
-					parent->focused || child->current.focused);
+			build_container(list, child,
+					parent->focused || child->current.focused,
+					parent->floater);
 		}
 	}
 }
 
 /**
- * Render a container's children using the L_TABBED layout.
+ * Build the active child of a tabbed or stacked container.
  */
-static void render_containers_tabbed(struct sway_output *output,
-		pixman_region32_t *damage, struct parent_data *parent) {
+static void build_active_child(struct render_list *list,
+		struct parent_data *parent, enum render_op_class class) {
+	struct sway_container *current = parent->active_child;
+	if (current->view) {
+		render_list_add(list, &(struct render_op){
+			.type = RENDER_OP_VIEW,
+			.class = class,
+			.con = current,
+			.floater = parent->floater,
+		});
+	} else {
+		build_container(list, current,
+				parent->focused || current->current.focused,
+				parent->floater);
+	}
+}
+
+/**
+ * Build a container's children using the L_TABBED layout.
+ */
+static void build_containers_tabbed(struct render_list *list,
+		struct parent_data *parent) {
 	if (!parent->children->length) {
 		return;
 	}
-	struct sway_container *current = parent->active_child;
-	struct border_colors *current_colors = &config->border_colors.unfocused;
+	enum render_op_class current_class = RENDER_CLASS_UNFOCUSED;
 	int tab_width = parent->box.width / parent->children->length;
 
-	// Render tabs
+	// Build tabs
 	for (int i = 0; i < parent->children->length; ++i) {
 		struct sway_container *child = parent->children->items[i];
-		struct sway_view *view = child->view;
 		struct sway_container_state *cstate = &child->current;
-		struct border_colors *colors;
-		struct wlr_texture *title_texture;
-		struct wlr_texture *marks_texture;
-		bool urgent = view ?
-			view_is_urgent(view) : container_has_urgent_child(child);
-
-		if (urgent) {
-			colors = &config->border_colors.urgent;
-			title_texture = child->title_urgent;
-			marks_texture = child->marks_urgent;
-		} else if (cstate->focused || parent->focused) {
-			colors = &config->border_colors.focused;
-			title_texture = child->title_focused;
-			marks_texture = child->marks_focused;
-		} else if (child == parent->active_child) {
-			colors = &config->border_colors.focused_inactive;
-			title_texture = child->title_focused_inactive;
-			marks_texture = child->marks_focused_inactive;
-		} else {
-			colors = &config->border_colors.unfocused;
-			title_texture = child->title_unfocused;
-			marks_texture = child->marks_unfocused;
-		}
+		enum render_op_class class = get_render_op_class(
+			cstate->focused || parent->focused,
+			child == parent->active_child);
 
 		int x = floor(cstate->x + tab_width * i);
 
@@ -813,88 +1115,68 @@ static void render_containers_tabbed(struct sway_output *output,
 			tab_width = parent->box.width - tab_width * i;
 		}
 
-		render_titlebar(output, damage, child, x, parent->box.y, tab_width,
-				colors, title_texture, marks_texture);
-
-		if (child == current) {
-			current_colors = colors;
+		render_list_add(list, &(struct render_op){
+			.type = RENDER_OP_TITLEBAR,
+			.class = class,
+			.con = child,
+			.x = x,
+			.y = parent->box.y,
+			.width = tab_width,
+			.floater = parent->floater,
+		});
+
+		if (child == parent->active_child) {
+			current_class = class;
 		}
 	}
 
-	// Render surface and left/right/bottom borders
-	if (current->view) {
-		render_view(output, damage, current, current_colors);
-	} else {
-		render_container(output, damage, current,
-				parent->focused || current->current.focused);
-	}
+	// Build surface and left/right/bottom borders
+	build_active_child(list, parent, current_class);
 }
 
 /**
- * Render a container's children using the L_STACKED layout.
+ * Build a container's children using the L_STACKED layout.
  */
-static void render_containers_stacked(struct sway_output *output,
-		pixman_region32_t *damage, struct parent_data *parent) {
+static void build_containers_stacked(struct render_list *list,
+		struct parent_data *parent) {
 	if (!parent->children->length) {
 		return;
 	}
-	struct sway_container *current = parent->active_child;
-	struct border_colors *current_colors = &config->border_colors.unfocused;
+	enum render_op_class current_class = RENDER_CLASS_UNFOCUSED;
 	size_t titlebar_height = container_titlebar_height();
 
-	// Render titles
+	// Build titles
 	for (int i = 0; i < parent->children->length; ++i) {
 		struct sway_container *child = parent->children->items[i];
-		struct sway_view *view = child->view;
-		struct sway_container_state *cstate = &child->current;
-		struct border_colors *colors;
-		struct wlr_texture *title_texture;
-		struct wlr_texture *marks_texture;
-		bool urgent = view ?
-			view_is_urgent(view) : container_has_urgent_child(child);
-
-		if (urgent) {
-			colors = &config->border_colors.urgent;
-			title_texture = child->title_urgent;
-			marks_texture = child->marks_urgent;
-		} else if (cstate->focused || parent->focused) {
-			colors = &config->border_colors.focused;
-			title_texture = child->title_focused;
-			marks_texture = child->marks_focused;
-		} else if (child == parent->active_child) {
-			colors = &config->border_colors.focused_inactive;
-			title_texture = child->title_focused_inactive;
-			marks_texture = child->marks_focused_inactive;
-		} else {
-			colors = &config->border_colors.unfocused;
-			title_texture = child->title_unfocused;
-			marks_texture = child->marks_unfocused;
-		}
-
-		int y = parent->box.y + titlebar_height * i;
-		render_titlebar(output, damage, child, parent->box.x, y,
-				parent->box.width, colors, title_texture, marks_texture);
-
-		if (child == current) {
-			current_colors = colors;
+		enum render_op_class class = get_render_op_class(
+			child->current.focused || parent->focused,
+			child == parent->active_child);
+
+		render_list_add(list, &(struct render_op){
+			.type = RENDER_OP_TITLEBAR,
+			.class = class,
+			.con = child,
+			.x = parent->box.x,
+			.y = parent->box.y + titlebar_height * i,
+			.width = parent->box.width,
+			.floater = parent->floater,
+		});
+
+		if (child == parent->active_child) {
+			current_class = class;
 		}
 	}
 
-	// Render surface and left/right/bottom borders
-	if (current->view) {
-		render_view(output, damage, current, current_colors);
-	} else {
-		render_container(output, damage, current,
-				parent->focused || current->current.focused);
-	}
+	// Build surface and left/right/bottom borders
+	build_active_child(list, parent, current_class);
 }
 
-static void render_containers(struct sway_output *output,
-		pixman_region32_t *damage, struct parent_data *parent) {
+static void build_containers(struct render_list *list,
+		struct parent_data *parent) {
 	if (config->hide_lone_tab && parent->children->length == 1) {
 		struct sway_container *child = parent->children->items[0];
 		if (child->view) {
-			render_containers_linear(output,damage, parent);
+			build_containers_linear(list, parent);
 			return;
 		}
 	}
@@ -903,19 +1185,19 @@ static void render_containers(struct sway_output *output,
 	case L_NONE:
 	case L_HORIZ:
 	case L_VERT:
-		render_containers_linear(output, damage, parent);
+		build_containers_linear(list, parent);
 		break;
 	case L_STACKED:
-		render_containers_stacked(output, damage, parent);
+		build_containers_stacked(list, parent);
 		break;
 	case L_TABBED:
-		render_containers_tabbed(output, damage, parent);
+		build_containers_tabbed(list, parent);
 		break;
 	}
 }
 
-static void render_container(struct sway_output *output,
-		pixman_region32_t *damage, struct sway_container *con, bool focused) {
+static void build_container(struct render_list *list,
+		struct sway_container *con, bool focused, int floater) {
 	struct parent_data data = {
 		.layout = con->current.layout,
 		.box = {
@@ -927,12 +1209,13 @@ static void render_container(struct sway_output *output,
 		.children = con->current.children,
 		.focused = focused,
 		.active_child = con->current.focused_inactive_child,
+		.floater = floater,
 	};
-	render_containers(output, damage, &data);
+	build_containers(list, &data);
 }
 
-static void render_workspace(struct sway_output *output,
-		pixman_region32_t *damage, struct sway_workspace *ws, bool focused) {
+static void build_workspace(struct render_list *list,
+		struct sway_workspace *ws, bool focused) {
 	struct parent_data data = {
 		.layout = ws->current.layout,
 		.box = {
@@ -944,47 +1227,26 @@ static void render_workspace(struct sway_output *output,
 		.children = ws->current.tiling,
 		.focused = focused,
 		.active_child = ws->current.focused_inactive_child,
+		.floater = -1,
 	};
-	render_containers(output, damage, &data);
+	build_containers(list, &data);
 }
 
-static void render_floating_container(struct sway_output *soutput,
-		pixman_region32_t *damage, struct sway_container *con) {
-	if (con->view) {
-		struct sway_view *view = con->view;
-		struct border_colors *colors;
-		struct wlr_texture *title_texture;
-		struct wlr_texture *marks_texture;
-
-		if (view_is_urgent(view)) {
-			colors = &config->border_colors.urgent;
-			title_texture = con->title_urgent;
-			marks_texture = con->marks_urgent;
-		} else if (con->current.focused) {
-			colors = &config->border_colors.focused;
-			title_texture = con->title_focused;
-			marks_texture = con->marks_focused;
-		} else {
-			colors = &config->border_colors.unfocused;
-			title_texture = con->title_unfocused;
-			marks_texture = con->marks_unfocused;
-		}
+static void build_floating_container(struct render_list *list,
+		struct sway_container *con) {
+	int floater = list->floaters->length;
+	list_add(list->floaters, con);
 
-		if (con->current.border == B_NORMAL) {
-			render_titlebar(soutput, damage, con, floor(con->current.x),
-					floor(con->current.y), con->current.width, colors,
-					title_texture, marks_texture);
-		} else if (con->current.border == B_PIXEL) {
-			render_top_border(soutput, damage, con, colors);
-		}
-		render_view(soutput, damage, con, colors);
+	if (con->view) {
+		enum render_op_class class = con->current.focused ?
+			RENDER_CLASS_FOCUSED : RENDER_CLASS_UNFOCUSED;
+		build_view(list, con, class, floater);
 	} else {
-		render_container(soutput, damage, con, con->current.focused);
+		build_container(list, con, con->current.focused, floater);
 	}
 }
 
-static void render_floating(struct sway_output *soutput,
-		pixman_region32_t *damage) {
+static void build_floating(struct render_list *list) {
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
 		for (int j = 0; j < output->current.workspaces->length; ++j) {
@@ -997,12 +1259,359 @@ static void render_floating(struct sway_output *soutput,
 				if (floater->current.fullscreen_mode != FULLSCREEN_NONE) {
 					continue;
 				}
-				render_floating_container(soutput, damage, floater);
+				build_floating_container(list, floater);
 			}
 		}
 	}
 }
 
+/**
+ * Rebuild the output's render list if the tree has changed since it was last
+ * built.
+ */
+static struct render_list *output_update_render_list(
+		struct sway_output *output, struct sway_workspace *workspace,
+		struct sway_container *fullscreen_con) {
+	struct render_list *list = output->render_list;
+	if (!list) {
+		list = calloc(1, sizeof(struct render_list));
+		if (!sway_assert(list, "Unable to allocate render list")) {
+			return NULL;
+		}
+		list->floaters = create_list();
+		output->render_list = list;
+		output->render_list_dirty = true;
+	}
+	if (!output->render_list_dirty && list->workspace == workspace &&
+			list->fullscreen == fullscreen_con) {
+		return list;
+	}
+
+	list->length = 0;
+	list->floaters->length = 0;
+	list->workspace = workspace;
+	list->fullscreen = fullscreen_con;
+	output->render_list_dirty = false;
+
+	if (!fullscreen_con) {
+		build_workspace(list, workspace, workspace->current.focused);
+		build_floating(list);
+		return list;
+	}
+
+	if (fullscreen_con->view) {
+		render_list_add(list, &(struct render_op){
+			.type = RENDER_OP_FULLSCREEN_VIEW,
+			.con = fullscreen_con,
+			.floater = -1,
+		});
+	} else {
+		build_container(list, fullscreen_con,
+				fullscreen_con->current.focused, -1);
+	}
+
+	for (int i = 0; i < workspace->current.floating->length; ++i) {
+		struct sway_container *floater = workspace->current.floating->items[i];
+		if (container_is_transient_for(floater, fullscreen_con)) {
+			build_floating_container(list, floater);
+		}
+	}
+	return list;
+}
+
+void render_list_destroy(struct render_list *list) {
+	if (!list) {
+		return;
+	}
+	free(list->ops);
+	list_free(list->floaters);
+	free(list);
+}
+
+/**
+ * Per-frame occlusion state for the floating containers.
+ *
+ * Floating containers are stacked above the tiling layout and above each
+ * other, so any part of them which is fully opaque hides whatever is drawn
+ * below. The damage which is passed down to each floater (and to the tiling
+ * layout) has the area covered by the floaters above it removed.
+ */
+struct floating_occlusion {
+	int length;
+	pixman_region32_t *damage; // visible damage for each floater
+	pixman_region32_t occluded; // output-buffer-local
+};
+
+static uint64_t region_area(pixman_region32_t *region) {
+	uint64_t area = 0;
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		area += (uint64_t)(rects[i].x2 - rects[i].x1) *
+			(rects[i].y2 - rects[i].y1);
+	}
+	return area;
+}
+
+/**
+ * Count the damaged pixels within a box which won't be rendered because they
+ * are occluded. The box is expected to be output-buffer-local.
+ */
+static uint64_t culled_area(pixman_region32_t *damage,
+		pixman_region32_t *occluded, const struct wlr_box *box) {
+	pixman_region32_t culled;
+	pixman_region32_init_rect(&culled, box->x, box->y,
+		box->width, box->height);
+	pixman_region32_intersect(&culled, &culled, damage);
+	pixman_region32_intersect(&culled, &culled, occluded);
+	uint64_t area = region_area(&culled);
+	pixman_region32_fini(&culled);
+	return area;
+}
+
+/**
+ * Scale a layout-local region to output-buffer-local coordinates and add it
+ * to the occluded region.
+ *
+ * Unlike wlr_region_scale, the rectangles are rounded inwards so that pixels
+ * which are only partially covered never end up in the occluded region.
+ */
+static void occlude_region(struct sway_output *output,
+		pixman_region32_t *occluded, pixman_region32_t *region) {
+	float scale = output->wlr_output->scale;
+	// With fractional scaling, texture filtering may blend the edge pixels
+	// with their transparent neighbours.
+	int inset = scale == floor(scale) ? 0 : 1;
+
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		int x1 = ceil((rects[i].x1 - output->lx) * scale) + inset;
+		int y1 = ceil((rects[i].y1 - output->ly) * scale) + inset;
+		int x2 = floor((rects[i].x2 - output->lx) * scale) - inset;
+		int y2 = floor((rects[i].y2 - output->ly) * scale) - inset;
+		if (x2 > x1 && y2 > y1) {
+			pixman_region32_union_rect(occluded, occluded,
+				x1, y1, x2 - x1, y2 - y1);
+		}
+	}
+}
+
+static struct border_colors *floating_container_colors(
+		struct sway_container *con) {
+	if (view_is_urgent(con->view)) {
+		return &config->border_colors.urgent;
+	} else if (con->current.focused) {
+		return &config->border_colors.focused;
+	}
+	return &config->border_colors.unfocused;
+}
+
+/**
+ * Add the parts of a floating view which are guaranteed to be drawn with
+ * fully opaque pixels to the occluded region. This is the opaque region of
+ * the view's main surface plus any borders and titlebar drawn in an opaque
+ * color.
+ */
+static void floating_view_occlude(struct sway_output *output,
+		struct sway_container *con, pixman_region32_t *occluded) {
+	struct sway_view *view = con->view;
+	struct sway_container_state *state = &con->current;
+	if (con->alpha < 1.0f) {
+		return;
+	}
+
+	// Layout-local
+	pixman_region32_t opaque;
+	pixman_region32_init(&opaque);
+
+	struct wlr_surface *surface = view->surface;
+	if (surface && wl_list_empty(&view->saved_buffers) &&
+			wlr_surface_has_buffer(surface)) {
+		pixman_region32_intersect_rect(&opaque, &surface->opaque_region,
+			0, 0, surface->current.width, surface->current.height);
+		pixman_region32_translate(&opaque,
+			floor(con->surface_x - view->geometry.x),
+			floor(con->surface_y - view->geometry.y));
+	}
+
+	struct border_colors *colors = floating_container_colors(con);
+	bool opaque_border = colors->child_border[3] == 1.0f;
+	if (state->border == B_NORMAL || state->border == B_PIXEL) {
+		if (opaque_border && state->border_left) {
+			pixman_region32_union_rect(&opaque, &opaque,
+				floor(state->x), floor(state->content_y),
+				state->border_thickness, state->content_height);
+		}
+		if (opaque_border && state->border_right) {
+			pixman_region32_union_rect(&opaque, &opaque,
+				floor(state->content_x + state->content_width),
+				floor(state->content_y),
+				state->border_thickness, state->content_height);
+		}
+		if (opaque_border && state->border_bottom) {
+			pixman_region32_union_rect(&opaque, &opaque,
+				floor(state->x),
+				floor(state->content_y + state->content_height),
+				state->width, state->border_thickness);
+		}
+	}
+	if (state->border == B_NORMAL) {
+		// The title and marks textures are painted onto the background color
+		if (colors->border[3] == 1.0f && colors->background[3] == 1.0f) {
+			pixman_region32_union_rect(&opaque, &opaque,
+				floor(state->x), floor(state->y),
+				state->width, container_titlebar_height());
+		}
+	} else if (state->border == B_PIXEL) {
+		if (opaque_border && state->border_top) {
+			pixman_region32_union_rect(&opaque, &opaque,
+				floor(state->x), floor(state->y),
+				state->width, state->border_thickness);
+		}
+	}
+
+	occlude_region(output, occluded, &opaque);
+	pixman_region32_fini(&opaque);
+}
+
+static void container_output_box(struct sway_output *output,
+		struct sway_container *con, struct wlr_box *box) {
+	box->x = floor(con->current.x) - output->lx;
+	box->y = floor(con->current.y) - output->ly;
+	box->width = con->current.width;
+	box->height = con->current.height;
+	scale_box(box, output->wlr_output->scale);
+}
+
+/**
+ * Work out which part of the damage is visible for each of the floating
+ * containers, walking from the top down.
+ */
+static void floating_occlusion_init(struct floating_occlusion *occlusion,
+		struct sway_output *soutput, list_t *floaters,
+		pixman_region32_t *damage) {
+	pixman_region32_init(&occlusion->occluded);
+	occlusion->length = 0;
+	occlusion->damage = calloc(floaters->length, sizeof(pixman_region32_t));
+	if (!sway_assert(occlusion->damage || floaters->length == 0,
+			"Unable to allocate floating damage")) {
+		return;
+	}
+	occlusion->length = floaters->length;
+
+	for (int i = floaters->length - 1; i >= 0; --i) {
+		struct sway_container *floater = floaters->items[i];
+		pixman_region32_init(&occlusion->damage[i]);
+		pixman_region32_subtract(&occlusion->damage[i], damage,
+			&occlusion->occluded);
+
+		if (debug.noculling || !floater->view) {
+			continue;
+		}
+		struct wlr_box box;
+		container_output_box(soutput, floater, &box);
+		soutput->render_stats.culled_pixels +=
+			culled_area(damage, &occlusion->occluded, &box);
+		floating_view_occlude(soutput, floater, &occlusion->occluded);
+	}
+}
+
+static void floating_occlusion_finish(struct floating_occlusion *occlusion) {
+	for (int i = 0; i < occlusion->length; ++i) {
+		pixman_region32_fini(&occlusion->damage[i]);
+	}
+	free(occlusion->damage);
+	pixman_region32_fini(&occlusion->occluded);
+}
+
+static struct border_colors *render_op_colors(struct render_op *op,
+		struct wlr_texture **title_texture,
+		struct wlr_texture **marks_texture) {
+	struct sway_container *con = op->con;
+	bool urgent = con->view ?
+		view_is_urgent(con->view) : container_has_urgent_child(con);
+
+	if (urgent) {
+		*title_texture = text_texture_get_texture(con->title_urgent);
+		*marks_texture = text_texture_get_texture(con->marks_urgent);
+		return &config->border_colors.urgent;
+	}
+	switch (op->class) {
+	case RENDER_CLASS_FOCUSED:
+		*title_texture = text_texture_get_texture(con->title_focused);
+		*marks_texture = text_texture_get_texture(con->marks_focused);
+		return &config->border_colors.focused;
+	case RENDER_CLASS_FOCUSED_INACTIVE:
+		*title_texture =
+			text_texture_get_texture(con->title_focused_inactive);
+		*marks_texture =
+			text_texture_get_texture(con->marks_focused_inactive);
+		return &config->border_colors.focused_inactive;
+	case RENDER_CLASS_UNFOCUSED:
+		break;
+	}
+	*title_texture = text_texture_get_texture(con->title_unfocused);
+	*marks_texture = text_texture_get_texture(con->marks_unfocused);
+	return &config->border_colors.unfocused;
+}
+
+/**
+ * Draw the render list. Floating containers get the damage which is left
+ * visible above them, everything else gets the tiling damage.
+ */
+static void render_list_replay(struct sway_output *output,
+		struct render_list *list, pixman_region32_t *tiling_damage,
+		struct floating_occlusion *occlusion) {
+	rect_batch_begin(output);
+	int floater = -1;
+	for (size_t i = 0; i < list->length; ++i) {
+		struct render_op *op = &list->ops[i];
+		// Each floater is stacked above everything before it. Within a
+		// floater, its surfaces may extend over its own titlebar.
+		if (op->floater != floater ||
+				(op->floater >= 0 && op->type == RENDER_OP_VIEW)) {
+			rect_batch_flush();
+			floater = op->floater;
+		}
+		pixman_region32_t *damage = tiling_damage;
+		if (op->floater >= 0) {
+			if (op->floater >= occlusion->length) {
+				continue;
+			}
+			damage = &occlusion->damage[op->floater];
+		}
+
+		struct sway_container *con = op->con;
+		struct wlr_texture *title_texture, *marks_texture;
+		struct border_colors *colors;
+
+		switch (op->type) {
+		case RENDER_OP_TITLEBAR:
+			colors = render_op_colors(op, &title_texture, &marks_texture);
+			render_titlebar(output, damage, con, op->x, op->y, op->width,
+					colors, title_texture, marks_texture);
+			break;
+		case RENDER_OP_TOP_BORDER:
+			colors = render_op_colors(op, &title_texture, &marks_texture);
+			render_top_border(output, damage, con, colors);
+			break;
+		case RENDER_OP_VIEW:
+			colors = render_op_colors(op, &title_texture, &marks_texture);
+			render_view(output, damage, con, colors);
+			break;
+		case RENDER_OP_FULLSCREEN_VIEW:
+			if (!wl_list_empty(&con->view->saved_buffers)) {
+				render_saved_view(con->view, output, damage, 1.0f);
+			} else if (con->view->surface) {
+				render_view_toplevels(con->view, output, damage, 1.0f);
+			}
+			break;
+		}
+	}
+	rect_batch_end();
+}
+
 static void render_seatops(struct sway_output *output,
 		pixman_region32_t *damage) {
 	struct sway_seat *seat;
@@ -1011,6 +1620,46 @@ static void render_seatops(struct sway_output *output,
 	}
 }
 
+/**
+ * Render the tiling layout and floating containers, or the fullscreen
+ * container and its transient floaters, from the output's render list.
+ */
+static void render_tree(struct sway_output *output, pixman_region32_t *damage,
+		struct sway_workspace *workspace,
+		struct sway_container *fullscreen_con) {
+	struct render_list *list =
+		output_update_render_list(output, workspace, fullscreen_con);
+	if (!list) {
+		return;
+	}
+
+	struct floating_occlusion occlusion;
+	floating_occlusion_init(&occlusion, output, list->floaters, damage);
+
+	pixman_region32_t tiling_damage;
+	pixman_region32_init(&tiling_damage);
+	pixman_region32_subtract(&tiling_damage, damage, &occlusion.occluded);
+
+	struct wlr_box tiling_box = {0};
+	if (fullscreen_con) {
+		wlr_output_transformed_resolution(output->wlr_output,
+			&tiling_box.width, &tiling_box.height);
+	} else {
+		tiling_box.x = floor(workspace->current.x) - output->lx;
+		tiling_box.y = floor(workspace->current.y) - output->ly;
+		tiling_box.width = workspace->current.width;
+		tiling_box.height = workspace->current.height;
+		scale_box(&tiling_box, output->wlr_output->scale);
+	}
+	output->render_stats.culled_pixels +=
+		culled_area(damage, &occlusion.occluded, &tiling_box);
+
+	render_list_replay(output, list, &tiling_damage, &occlusion);
+
+	pixman_region32_fini(&tiling_damage);
+	floating_occlusion_finish(&occlusion);
+}
+
 void output_render(struct sway_output *output, struct timespec *when,
 		pixman_region32_t *damage) {
 	struct wlr_output *wlr_output = output->wlr_output;
@@ -1032,6 +1681,11 @@ void output_render(struct sway_output *output, struct timespec *when,
 		fullscreen_con = workspace->current.fullscreen;
 	}
 
+	memset(&output->render_stats, 0, sizeof(output->render_stats));
+
+	struct timespec render_start;
+	clock_gettime(CLOCK_MONOTONIC, &render_start);
+
 	wlr_renderer_begin(renderer, wlr_output->width, wlr_output->height);
 
 	if (!pixman_region32_not_empty(damage)) {
@@ -1047,6 +1701,13 @@ void output_render(struct sway_output *output, struct timespec *when,
 		pixman_region32_union_rect(damage, damage, 0, 0, width, height);
 	}
 
+	output->render_stats.damage_rects = pixman_region32_n_rects(damage);
+	if (debug.damage_max_rects > 0) {
+		simplify_damage(damage, debug.damage_max_rects);
+	}
+	output->render_stats.damage_rects_simplified =
+		pixman_region32_n_rects(damage);
+
 	if (output_has_opaque_overlay_layer_surface(output)) {
 		goto render_overlay;
 	}
@@ -1061,25 +1722,7 @@ void output_render(struct sway_output *output, struct timespec *when,
 			wlr_renderer_clear(renderer, clear_color);
 		}
 
-		if (fullscreen_con->view) {
-			if (!wl_list_empty(&fullscreen_con->view->saved_buffers)) {
-				render_saved_view(fullscreen_con->view, output, damage, 1.0f);
-			} else if (fullscreen_con->view->surface) {
-				render_view_toplevels(fullscreen_con->view,
-						output, damage, 1.0f);
-			}
-		} else {
-			render_container(output, damage, fullscreen_con,
-					fullscreen_con->current.focused);
-		}
-
-		for (int i = 0; i < workspace->current.floating->length; ++i) {
-			struct sway_container *floater =
-				workspace->current.floating->items[i];
-			if (container_is_transient_for(floater, fullscreen_con)) {
-				render_floating_container(output, damage, floater);
-			}
-		}
+		render_tree(output, damage, workspace, fullscreen_con);
 #if HAVE_XWAYLAND
 		render_unmanaged(output, damage, &root->xwayland_unmanaged);
 #endif
@@ -1098,8 +1741,7 @@ void output_render(struct sway_output *output, struct timespec *when,
 		render_layer_toplevel(output, damage,
 			&output->layers[ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM]);
 
-		render_workspace(output, damage, workspace, workspace->current.focused);
-		render_floating(output, damage);
+		render_tree(output, damage, workspace, NULL);
 #if HAVE_XWAYLAND
 		render_unmanaged(output, damage, &root->xwayland_unmanaged);
 #endif
@@ -1153,8 +1795,39 @@ renderer_end:
 	wlr_output_set_damage(wlr_output, &frame_damage);
 	pixman_region32_fini(&frame_damage);
 
+	if (debug.render_stats) {
+		struct sway_render_stats *stats = &output->render_stats;
+		struct sway_text_texture_stats text_stats;
+		text_texture_cache_get_stats(&text_stats);
+		size_t lookups = text_stats.hits + text_stats.misses;
+		sway_log(SWAY_DEBUG, "Frame on %s: %d damage rectangles "
+			"(%d after merging), culled %" PRIu64 " pixels, "
+			"%zu rectangles, %zu scissors, text cache %.1f%% hits "
+			"(%zu textures, %zu unused)", wlr_output->name,
+			stats->damage_rects, stats->damage_rects_simplified,
+			stats->culled_pixels, stats->rect_draws, stats->scissors,
+			lookups ? 100.0 * text_stats.hits / lookups : 0.0,
+			text_stats.entries, text_stats.unused);
+	}
+
+	struct timespec render_end;
+	clock_gettime(CLOCK_MONOTONIC, &render_end);
+
 	if (!wlr_output_commit(wlr_output)) {
 		return;
 	}
 	output->last_frame = *when;
+
+	if (output->max_render_time_auto) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		render_time_auto_add_sample(&output->render_time_auto,
+			timespec_diff_usec(&render_start, &now));
+	}
+
+	struct timespec committed;
+	clock_gettime(wlr_backend_get_presentation_clock(server.backend),
+		&committed);
+	frame_stats_handle_commit(&output->frame_stats, &render_start,
+		&render_end, &committed);
 }
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <wayland-server-core.h>
 #include <wlr/types/wlr_buffer.h>
 #include "sway/config.h"
 #include "sway/desktop.h"
@@ -10,13 +11,57 @@
 #include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
+#include "sway/ipc-json.h"
+#include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/tree/container.h"
 #include "sway/tree/node.h"
+#include "sway/tree/root.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
+#include "hash_table.h"
 #include "list.h"
 #include "log.h"
+#include "pool.h"
+
+// Recent configures kept per client for the latency percentile
+#define LATENCY_SAMPLES 32
+// Configures measured before a client gets its own timeout
+#define LATENCY_MIN_SAMPLES 8
+// Weight of a new sample in the moving average
+#define LATENCY_EMA_ALPHA 0.2
+// Lower bound of a learned timeout, in milliseconds
+#define LATENCY_MIN_TIMEOUT 30
+// Timeout of clients flagged as slow, in milliseconds
+#define LATENCY_SLOW_TIMEOUT 50
+
+struct client_latency {
+	struct wl_client *client;
+	struct wl_listener client_destroy;
+	struct wl_list link; // client_latencies
+	struct wl_list views; // sway_view::latency_link
+
+	uint32_t samples[LATENCY_SAMPLES]; // In microseconds
+	size_t nsamples, next;
+	double ema_ms;
+	size_t timeouts;
+	bool slow;
+};
+
+static struct wl_list client_latencies = {0}; // client_latency::link
+
+static struct sway_transaction_stats stats = {0};
+
+// Lists kept for reuse by the states of later transactions
+#define SPARE_LISTS_MAX 256
+
+static pool_t *transaction_pool = NULL;
+static pool_t *instruction_pool = NULL;
+static list_t *spare_lists = NULL;
+// The lists handed out by transaction_list_create, keyed by address, since
+// lists created elsewhere are released through transaction_list_free too
+static hash_table_t *lists_in_use = NULL;
+static struct pool_stats list_stats = { .name = "transaction_list" };
 
 struct sway_transaction {
 	struct wl_event_source *timer;
@@ -24,6 +69,14 @@ struct sway_transaction {
 	size_t num_waiting;
 	size_t num_configures;
 	struct timespec commit_time;
+	uint32_t timeout_ms;
+	struct sway_transaction_record record;
+
+	// The outputs on which the nodes of the transaction are or will be shown.
+	// Transactions sharing an output have to be applied in order; the others
+	// are independent.
+	list_t *outputs; // struct sway_output *
+	bool global; // Touches nodes which aren't on any output
 };
 
 struct sway_transaction_instruction {
@@ -39,13 +92,61 @@ struct sway_transaction_instruction {
 	bool waiting;
 };
 
+/**
+ * Get an empty list, reusing one released by an earlier transaction if there
+ * is any.
+ */
+static list_t *transaction_list_create(void) {
+	list_t *list;
+	if (spare_lists && spare_lists->length) {
+		list = spare_lists->items[--spare_lists->length];
+		list_stats.cached--;
+		list_stats.reuses++;
+	} else {
+		list = create_list();
+	}
+	if (list && lists_in_use) {
+		hash_table_set_id(lists_in_use, (uintptr_t)list, list);
+		list_stats.in_use++;
+	}
+	list_stats.allocations++;
+	return list;
+}
+
+static void transaction_list_free(list_t *list) {
+	if (!list) {
+		return;
+	}
+	if (lists_in_use && hash_table_get_id(lists_in_use, (uintptr_t)list)) {
+		hash_table_del_id(lists_in_use, (uintptr_t)list, list);
+		list_stats.in_use--;
+	}
+	if (!spare_lists || spare_lists->length >= SPARE_LISTS_MAX) {
+		list_free(list);
+		return;
+	}
+	list->length = 0;
+	list_add(spare_lists, list);
+	list_stats.cached++;
+}
+
 static struct sway_transaction *transaction_create(void) {
+	if (!transaction_pool) {
+		transaction_pool =
+			create_pool("transaction", sizeof(struct sway_transaction));
+		instruction_pool = create_pool("transaction_instruction",
+			sizeof(struct sway_transaction_instruction));
+		spare_lists = create_list();
+		lists_in_use = create_hash_table();
+		pool_stats_register(&list_stats);
+	}
 	struct sway_transaction *transaction =
-		calloc(1, sizeof(struct sway_transaction));
+		transaction_pool ? pool_alloc(transaction_pool) : NULL;
 	if (!sway_assert(transaction, "Unable to allocate transaction")) {
 		return NULL;
 	}
-	transaction->instructions = create_list();
+	transaction->instructions = transaction_list_create();
+	transaction->outputs = transaction_list_create();
 	return transaction;
 }
 
@@ -75,14 +176,15 @@ static void transaction_destroy(struct sway_transaction *transaction) {
 				break;
 			}
 		}
-		free(instruction);
+		pool_free(instruction_pool, instruction);
 	}
-	list_free(transaction->instructions);
+	transaction_list_free(transaction->instructions);
+	transaction_list_free(transaction->outputs);
 
 	if (transaction->timer) {
 		wl_event_source_remove(transaction->timer);
 	}
-	free(transaction);
+	pool_free(transaction_pool, transaction);
 }
 
 static void copy_output_state(struct sway_output *output,
@@ -91,13 +193,30 @@ static void copy_output_state(struct sway_output *output,
 	if (state->workspaces) {
 		state->workspaces->length = 0;
 	} else {
-		state->workspaces = create_list();
+		state->workspaces = transaction_list_create();
 	}
 	list_cat(state->workspaces, output->workspaces);
 
 	state->active_workspace = output_get_active_workspace(output);
 }
 
+/**
+ * Replace the contents of dest with a copy of src, or free it if src is NULL.
+ */
+static void copy_list(list_t **dest, list_t *src) {
+	if (!src) {
+		list_free(*dest);
+		*dest = NULL;
+		return;
+	}
+	if (*dest) {
+		(*dest)->length = 0;
+	} else {
+		*dest = create_list();
+	}
+	list_cat(*dest, src);
+}
+
 static void copy_workspace_state(struct sway_workspace *ws,
 		struct sway_transaction_instruction *instruction) {
 	struct sway_workspace_state *state = &instruction->workspace_state;
@@ -113,16 +232,25 @@ static void copy_workspace_state(struct sway_workspace *ws,
 	if (state->floating) {
 		state->floating->length = 0;
 	} else {
-		state->floating = create_list();
+		state->floating = transaction_list_create();
 	}
 	if (state->tiling) {
 		state->tiling->length = 0;
 	} else {
-		state->tiling = create_list();
+		state->tiling = transaction_list_create();
 	}
 	list_cat(state->floating, ws->floating);
 	list_cat(state->tiling, ws->tiling);
 
+	// Keep what was sent so arranging can tell whether it changed since
+	list_t *floating = ws->transacted.floating;
+	list_t *tiling = ws->transacted.tiling;
+	memcpy(&ws->transacted, state, sizeof(struct sway_workspace_state));
+	ws->transacted.floating = floating;
+	ws->transacted.tiling = tiling;
+	copy_list(&ws->transacted.floating, ws->floating);
+	copy_list(&ws->transacted.tiling, ws->tiling);
+
 	struct sway_seat *seat = input_manager_current_seat();
 	state->focused = seat_get_focus(seat) == &ws->node;
 
@@ -140,18 +268,28 @@ static void copy_container_state(struct sway_container *container,
 		struct sway_transaction_instruction *instruction) {
 	struct sway_container_state *state = &instruction->container_state;
 
-	if (state->children) {
-		list_free(state->children);
-	}
-
+	list_t *state_children = state->children;
 	memcpy(state, &container->pending, sizeof(struct sway_container_state));
 
+	// Keep what was sent so arranging can tell whether it changed since
+	list_t *transacted_children = container->transacted.children;
+	memcpy(&container->transacted, &container->pending,
+			sizeof(struct sway_container_state));
+	container->transacted.children = transacted_children;
+	copy_list(&container->transacted.children, container->pending.children);
+
 	if (!container->view) {
 		// We store a copy of the child list to avoid having it mutated after
 		// we copy the state.
-		state->children = create_list();
-		list_cat(state->children, container->pending.children);
+		if (state_children) {
+			state_children->length = 0;
+		} else {
+			state_children = transaction_list_create();
+		}
+		list_cat(state_children, container->pending.children);
+		state->children = state_children;
 	} else {
+		transaction_list_free(state_children);
 		state->children = NULL;
 	}
 
@@ -183,7 +321,7 @@ static void transaction_add_node(struct sway_transaction *transaction,
 	}
 
 	if (!instruction) {
-		instruction = calloc(1, sizeof(struct sway_transaction_instruction));
+		instruction = instruction_pool ? pool_alloc(instruction_pool) : NULL;
 		if (!sway_assert(instruction, "Unable to allocate instruction")) {
 			return;
 		}
@@ -215,7 +353,7 @@ static void transaction_add_node(struct sway_transaction *transaction,
 static void apply_output_state(struct sway_output *output,
 		struct sway_output_state *state) {
 	output_damage_whole(output);
-	list_free(output->current.workspaces);
+	transaction_list_free(output->current.workspaces);
 	memcpy(&output->current, state, sizeof(struct sway_output_state));
 	output_damage_whole(output);
 }
@@ -223,8 +361,8 @@ static void apply_output_state(struct sway_output *output,
 static void apply_workspace_state(struct sway_workspace *ws,
 		struct sway_workspace_state *state) {
 	output_damage_whole(ws->current.output);
-	list_free(ws->current.floating);
-	list_free(ws->current.tiling);
+	transaction_list_free(ws->current.floating);
+	transaction_list_free(ws->current.tiling);
 	memcpy(&ws->current, state, sizeof(struct sway_workspace_state));
 	output_damage_whole(ws->current.output);
 }
@@ -252,7 +390,7 @@ static void apply_container_state(struct sway_container *container,
 	// (ie. con->children). The list itself needs to be freed here.
 	// Any child containers which are being deleted will be cleaned up in
 	// transaction_destroy().
-	list_free(container->current.children);
+	transaction_list_free(container->current.children);
 
 	memcpy(&container->current, state, sizeof(struct sway_container_state));
 
@@ -287,11 +425,73 @@ static void apply_container_state(struct sway_container *container,
 	}
 }
 
+static uint64_t get_elapsed_usec(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	int64_t nsec = (int64_t)(now.tv_sec - start->tv_sec) * 1000000000 +
+		(now.tv_nsec - start->tv_nsec);
+	return nsec > 0 ? nsec / 1000 : 0;
+}
+
+static const char *view_get_app_name(struct sway_view *view) {
+	const char *name = view_get_app_id(view);
+	if (!name) {
+		name = view_get_class(view);
+	}
+	return name ? name : "unknown";
+}
+
+static void record_app_timeout(struct sway_view *view) {
+	if (!stats.app_timeouts) {
+		stats.app_timeouts = create_list();
+	}
+	const char *app_id = view_get_app_name(view);
+	for (int i = 0; i < stats.app_timeouts->length; ++i) {
+		struct sway_transaction_app_timeouts *app = stats.app_timeouts->items[i];
+		if (strcmp(app->app_id, app_id) == 0) {
+			app->count++;
+			return;
+		}
+	}
+	struct sway_transaction_app_timeouts *app =
+		calloc(1, sizeof(struct sway_transaction_app_timeouts));
+	if (!sway_assert(app, "Unable to allocate app timeouts")) {
+		return;
+	}
+	app->app_id = strdup(app_id);
+	app->count = 1;
+	list_add(stats.app_timeouts, app);
+}
+
+static void record_apply(struct sway_transaction *transaction) {
+	struct sway_transaction_record *record = &transaction->record;
+	record->apply_usec = get_elapsed_usec(&transaction->commit_time);
+
+	stats.applied++;
+	if (record->timed_out) {
+		stats.timed_out++;
+	}
+	histogram_add(&stats.wait_time, record->wait_usec);
+	histogram_add(&stats.apply_time, record->apply_usec);
+	stats.history[stats.history_next] = *record;
+	stats.history_next = (stats.history_next + 1) % TRANSACTION_HISTORY;
+	if (stats.history_len < TRANSACTION_HISTORY) {
+		stats.history_len++;
+	}
+
+	ipc_event_transaction(record);
+}
+
+const struct sway_transaction_stats *transaction_get_stats(void) {
+	return &stats;
+}
+
 /**
  * Apply a transaction to the "current" state of the tree.
  */
 static void transaction_apply(struct sway_transaction *transaction) {
 	sway_log(SWAY_DEBUG, "Applying transaction %p", transaction);
+	record_apply(transaction);
 	if (debug.txn_timings) {
 		struct timespec now;
 		clock_gettime(CLOCK_MONOTONIC, &now);
@@ -321,29 +521,233 @@ static void transaction_apply(struct sway_transaction *transaction) {
 		case N_CONTAINER:
 			apply_container_state(node->sway_container,
 					&instruction->container_state);
+			// The current border is described
+			ipc_json_invalidate_node(node);
 			break;
 		}
 
 		node->instruction = NULL;
 	}
 
+	// The current tree has changed, so the render lists and hit indexes need
+	// rebuilding
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		output->render_list_dirty = true;
+		for (int j = 0; j < output->workspaces->length; ++j) {
+			struct sway_workspace *ws = output->workspaces->items[j];
+			hit_index_invalidate(&ws->hit_index);
+		}
+	}
+
 	cursor_rebase_all();
 }
 
 static void transaction_commit_pending(void);
 
-static void transaction_progress(void) {
-	if (!server.queued_transaction) {
+static void handle_client_destroy(struct wl_listener *listener, void *data) {
+	struct client_latency *latency =
+		wl_container_of(listener, latency, client_destroy);
+	struct sway_view *view, *tmp;
+	wl_list_for_each_safe(view, tmp, &latency->views, latency_link) {
+		wl_list_remove(&view->latency_link);
+		wl_list_init(&view->latency_link);
+	}
+	wl_list_remove(&latency->link);
+	wl_list_remove(&latency->client_destroy.link);
+	free(latency);
+}
+
+static struct wl_client *view_get_client(struct sway_view *view) {
+	if (!view->surface) {
+		return NULL;
+	}
+	return wl_resource_get_client(view->surface->resource);
+}
+
+static struct client_latency *client_latency_find(struct wl_client *client) {
+	if (!client_latencies.next) {
+		wl_list_init(&client_latencies);
+	}
+	struct client_latency *latency;
+	wl_list_for_each(latency, &client_latencies, link) {
+		if (latency->client == client) {
+			return latency;
+		}
+	}
+	return NULL;
+}
+
+static struct client_latency *client_latency_get(struct wl_client *client) {
+	struct client_latency *latency = client_latency_find(client);
+	if (latency) {
+		return latency;
+	}
+	latency = calloc(1, sizeof(struct client_latency));
+	if (!sway_assert(latency, "Unable to allocate client latency")) {
+		return NULL;
+	}
+	latency->client = client;
+	wl_list_init(&latency->views);
+	latency->client_destroy.notify = handle_client_destroy;
+	wl_client_add_destroy_listener(client, &latency->client_destroy);
+	wl_list_insert(&client_latencies, &latency->link);
+	return latency;
+}
+
+static double client_latency_p95_ms(struct client_latency *latency) {
+	uint32_t sorted[LATENCY_SAMPLES];
+	size_t n = latency->nsamples;
+	memcpy(sorted, latency->samples, n * sizeof(sorted[0]));
+	// Insertion sort, there are only a few samples
+	for (size_t i = 1; i < n; ++i) {
+		uint32_t sample = sorted[i];
+		size_t j = i;
+		for (; j > 0 && sorted[j - 1] > sample; --j) {
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = sample;
+	}
+	return n ? sorted[n * 95 / 100] / 1000.0 : 0;
+}
+
+static void client_latency_add_sample(struct sway_view *view, uint64_t usec) {
+	struct wl_client *client = view_get_client(view);
+	struct client_latency *latency = client ? client_latency_get(client) : NULL;
+	if (!latency) {
+		return;
+	}
+	latency->samples[latency->next] = usec < UINT32_MAX ? usec : UINT32_MAX;
+	latency->next = (latency->next + 1) % LATENCY_SAMPLES;
+	if (latency->nsamples < LATENCY_SAMPLES) {
+		latency->nsamples++;
+	}
+	double ms = usec / 1000.0;
+	latency->ema_ms = latency->ema_ms == 0 ? ms :
+		latency->ema_ms + LATENCY_EMA_ALPHA * (ms - latency->ema_ms);
+
+	bool slow = latency->nsamples >= LATENCY_MIN_SAMPLES &&
+		latency->ema_ms > server.txn_timeout_ms / 2.0;
+	if (slow != latency->slow) {
+		pid_t pid;
+		wl_client_get_credentials(client, &pid, NULL, NULL);
+		sway_log(SWAY_INFO, "Client %d is %s slow to configure "
+			"(%.1fms on average)", pid, slow ? "now" : "no longer",
+			latency->ema_ms);
+		latency->slow = slow;
+	}
+
+	// Only the views which described the latency since it last changed
+	struct sway_view *described, *tmp;
+	wl_list_for_each_safe(described, tmp, &latency->views, latency_link) {
+		if (described->container) {
+			ipc_json_invalidate_node(&described->container->node);
+		}
+		wl_list_remove(&described->latency_link);
+		wl_list_init(&described->latency_link);
+	}
+}
+
+static void client_latency_add_timeout(struct sway_view *view) {
+	struct wl_client *client = view_get_client(view);
+	struct client_latency *latency = client ? client_latency_get(client) : NULL;
+	if (latency) {
+		latency->timeouts++;
+	}
+}
+
+/**
+ * Keep measuring a configure after its transaction stopped waiting for it, so
+ * the latency of the client isn't capped by the timeout it was given.
+ */
+static void view_set_late_configure(struct sway_view *view,
+		struct sway_transaction_instruction *instruction) {
+	struct sway_transaction *transaction = instruction->transaction;
+	struct sway_container_state *state = &instruction->container_state;
+	view->late_configure = true;
+	view->late_configure_serial = instruction->serial;
+	view->late_configure_geometry.x = state->content_x;
+	view->late_configure_geometry.y = state->content_y;
+	view->late_configure_geometry.width = state->content_width;
+	view->late_configure_geometry.height = state->content_height;
+	view->late_configure_time = transaction->commit_time;
+	view->late_configure_timeout_ms = transaction->timeout_ms;
+}
+
+/**
+ * Sample the latency of a late configure once the client acked it. When it is
+ * superseded by a new configure instead, the client may have been idle since,
+ * so only the timeout which it missed is known to have passed.
+ */
+static void view_finish_late_configure(struct sway_view *view, bool acked) {
+	if (!view->late_configure) {
 		return;
 	}
-	if (server.queued_transaction->num_waiting > 0) {
+	view->late_configure = false;
+	client_latency_add_sample(view, acked ?
+		get_elapsed_usec(&view->late_configure_time) :
+		(uint64_t)view->late_configure_timeout_ms * 1000);
+}
+
+/**
+ * How long to wait for a view before applying a transaction without it.
+ */
+static uint32_t view_get_timeout(struct sway_view *view) {
+	struct wl_client *client = view_get_client(view);
+	struct client_latency *latency =
+		client ? client_latency_find(client) : NULL;
+	if (!latency || latency->nsamples < LATENCY_MIN_SAMPLES) {
+		return server.txn_timeout_ms;
+	}
+	if (latency->slow) {
+		return LATENCY_SLOW_TIMEOUT;
+	}
+	// Leave a margin above the recent latency for the odd slower frame
+	uint32_t timeout = client_latency_p95_ms(latency) * 1.5 + 10;
+	if (timeout < LATENCY_MIN_TIMEOUT) {
+		timeout = LATENCY_MIN_TIMEOUT;
+	}
+	return timeout < server.txn_timeout_ms ? timeout : server.txn_timeout_ms;
+}
+
+bool transaction_get_view_latency(struct sway_view *view,
+		struct sway_client_latency_stats *stats) {
+	struct wl_client *client = view_get_client(view);
+	struct client_latency *latency =
+		client ? client_latency_find(client) : NULL;
+	if (!latency) {
+		return false;
+	}
+	if (wl_list_empty(&view->latency_link)) {
+		wl_list_insert(&latency->views, &view->latency_link);
+	}
+	stats->ema_ms = latency->ema_ms;
+	stats->p95_ms = client_latency_p95_ms(latency);
+	stats->samples = latency->nsamples;
+	stats->timeouts = latency->timeouts;
+	stats->slow = latency->slow;
+	return true;
+}
+
+static void transaction_progress(void) {
+	bool applied = false;
+	for (int i = 0; i < server.queued_transactions->length;) {
+		struct sway_transaction *transaction =
+			server.queued_transactions->items[i];
+		if (transaction->num_waiting > 0) {
+			++i;
+			continue;
+		}
+		list_del(server.queued_transactions, i);
+		transaction_apply(transaction);
+		transaction_destroy(transaction);
+		applied = true;
+	}
+	if (!applied) {
 		return;
 	}
-	transaction_apply(server.queued_transaction);
-	transaction_destroy(server.queued_transaction);
-	server.queued_transaction = NULL;
 
-	if (!server.pending_transaction) {
+	if (!server.pending_transactions->length) {
 		sway_idle_inhibit_v1_check_active(server.idle_inhibit_manager_v1);
 		return;
 	}
@@ -353,8 +757,26 @@ static void transaction_progress(void) {
 
 static int handle_timeout(void *data) {
 	struct sway_transaction *transaction = data;
-	sway_log(SWAY_DEBUG, "Transaction %p timed out (%zi waiting)",
-			transaction, transaction->num_waiting);
+	sway_log(SWAY_DEBUG, "Transaction %p timed out after %ums (%zi waiting)",
+			transaction, transaction->timeout_ms, transaction->num_waiting);
+
+	// The latency of the views which didn't make it is sampled once they ack
+	for (int i = 0; i < transaction->instructions->length; ++i) {
+		struct sway_transaction_instruction *instruction =
+			transaction->instructions->items[i];
+		if (instruction->waiting &&
+				instruction->node->instruction == instruction) {
+			struct sway_view *view = instruction->node->sway_container->view;
+			client_latency_add_timeout(view);
+			view_set_late_configure(view, instruction);
+			record_app_timeout(view);
+			transaction->record.timeouts++;
+		}
+	}
+
+	transaction->record.timed_out = true;
+	transaction->record.wait_usec =
+		get_elapsed_usec(&transaction->commit_time);
 	transaction->num_waiting = 0;
 	transaction_progress();
 	return 0;
@@ -394,17 +816,38 @@ static bool should_configure(struct sway_node *node,
 	return true;
 }
 
+/**
+ * Whether the view of an instruction keeps its current geometry, in which
+ * case it can keep rendering its live surface until the transaction applies.
+ */
+static bool view_keeps_geometry(struct sway_node *node,
+		struct sway_transaction_instruction *instruction) {
+	struct sway_container *con = node->sway_container;
+	if (node->destroying || !con->view->surface) {
+		return false;
+	}
+	struct sway_container_state *cstate = &con->current;
+	struct sway_container_state *istate = &instruction->container_state;
+	return cstate->content_x == istate->content_x &&
+		cstate->content_y == istate->content_y &&
+		cstate->content_width == istate->content_width &&
+		cstate->content_height == istate->content_height;
+}
+
 static void transaction_commit(struct sway_transaction *transaction) {
 	sway_log(SWAY_DEBUG, "Transaction %p committing with %i instructions",
 			transaction, transaction->instructions->length);
 	transaction->num_waiting = 0;
+	transaction->timeout_ms = 0;
 	for (int i = 0; i < transaction->instructions->length; ++i) {
 		struct sway_transaction_instruction *instruction =
 			transaction->instructions->items[i];
 		struct sway_node *node = instruction->node;
 		bool hidden = node_is_view(node) &&
 			!view_is_visible(node->sway_container->view);
-		if (should_configure(node, instruction)) {
+		bool configure = should_configure(node, instruction);
+		if (configure) {
+			view_finish_late_configure(node->sway_container->view, false);
 			instruction->serial = view_configure(node->sway_container->view,
 					instruction->container_state.content_x,
 					instruction->container_state.content_y,
@@ -413,6 +856,12 @@ static void transaction_commit(struct sway_transaction *transaction) {
 			if (!hidden) {
 				instruction->waiting = true;
 				++transaction->num_waiting;
+
+				uint32_t timeout =
+					view_get_timeout(node->sway_container->view);
+				if (timeout > transaction->timeout_ms) {
+					transaction->timeout_ms = timeout;
+				}
 			}
 
 			// From here on we are rendering a saved buffer of the view, which
@@ -424,8 +873,11 @@ static void transaction_commit(struct sway_transaction *transaction) {
 			wlr_surface_send_frame_done(
 					node->sway_container->view->surface, &now);
 		}
+		// Views which aren't resized or moved, such as in focus or title only
+		// transactions, don't need a snapshot of their buffers
 		if (!hidden && node_is_view(node) &&
-				wl_list_empty(&node->sway_container->view->saved_buffers)) {
+				wl_list_empty(&node->sway_container->view->saved_buffers) &&
+				(configure || !view_keeps_geometry(node, instruction))) {
 			view_save_buffer(node->sway_container->view);
 			memcpy(&node->sway_container->view->saved_geometry,
 					&node->sway_container->view->geometry,
@@ -434,15 +886,17 @@ static void transaction_commit(struct sway_transaction *transaction) {
 		node->instruction = instruction;
 	}
 	transaction->num_configures = transaction->num_waiting;
-	if (debug.txn_timings) {
-		clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
-	}
+	clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
+	transaction->record.id = ++stats.committed;
+	transaction->record.nodes = transaction->instructions->length;
+	transaction->record.configures = transaction->num_configures;
 	if (debug.noatomic) {
 		transaction->num_waiting = 0;
 	} else if (debug.txn_wait) {
 		// Force the transaction to time out even if all views are ready.
 		// We do this by inflating the waiting counter.
 		transaction->num_waiting += 1000000;
+		transaction->timeout_ms = server.txn_timeout_ms;
 	}
 
 	if (transaction->num_waiting) {
@@ -451,7 +905,8 @@ static void transaction_commit(struct sway_transaction *transaction) {
 				handle_timeout, transaction);
 		if (transaction->timer) {
 			wl_event_source_timer_update(transaction->timer,
-					server.txn_timeout_ms);
+					transaction->timeout_ms);
+			transaction->record.timeout_ms = transaction->timeout_ms;
 		} else {
 			sway_log_errno(SWAY_ERROR, "Unable to create transaction timer "
 					"(some imperfect frames might be rendered)");
@@ -460,14 +915,42 @@ static void transaction_commit(struct sway_transaction *transaction) {
 	}
 }
 
+static bool transaction_conflicts(struct sway_transaction *transaction,
+		list_t *outputs, bool global) {
+	if (transaction->global || global) {
+		return true;
+	}
+	for (int i = 0; i < outputs->length; ++i) {
+		if (list_find(transaction->outputs, outputs->items[i]) != -1) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool transaction_is_blocked(struct sway_transaction *transaction) {
+	for (int i = 0; i < server.queued_transactions->length; ++i) {
+		struct sway_transaction *queued = server.queued_transactions->items[i];
+		if (transaction_conflicts(queued, transaction->outputs,
+					transaction->global)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 static void transaction_commit_pending(void) {
-	if (server.queued_transaction) {
-		return;
+	for (int i = 0; i < server.pending_transactions->length;) {
+		struct sway_transaction *transaction =
+			server.pending_transactions->items[i];
+		if (transaction_is_blocked(transaction)) {
+			++i;
+			continue;
+		}
+		list_del(server.pending_transactions, i);
+		list_add(server.queued_transactions, transaction);
+		transaction_commit(transaction);
 	}
-	struct sway_transaction *transaction = server.pending_transaction;
-	server.pending_transaction = NULL;
-	server.queued_transaction = transaction;
-	transaction_commit(transaction);
 	transaction_progress();
 }
 
@@ -488,10 +971,17 @@ static void set_instruction_ready(
 				instruction->node->sway_container->title);
 	}
 
+	if (instruction->waiting && transaction->num_waiting > 0) {
+		client_latency_add_sample(instruction->node->sway_container->view,
+			get_elapsed_usec(&transaction->commit_time));
+	}
+
 	// If the transaction has timed out then its num_waiting will be 0 already.
 	if (instruction->waiting && transaction->num_waiting > 0 &&
 			--transaction->num_waiting == 0) {
 		sway_log(SWAY_DEBUG, "Transaction %p is ready", transaction);
+		transaction->record.wait_usec =
+			get_elapsed_usec(&transaction->commit_time);
 		wl_event_source_timer_update(transaction->timer, 0);
 	}
 
@@ -505,6 +995,8 @@ void transaction_notify_view_ready_by_serial(struct sway_view *view,
 		view->container->node.instruction;
 	if (instruction != NULL && instruction->serial == serial) {
 		set_instruction_ready(instruction);
+	} else if (view->late_configure && view->late_configure_serial == serial) {
+		view_finish_late_configure(view, true);
 	}
 }
 
@@ -518,27 +1010,154 @@ void transaction_notify_view_ready_by_geometry(struct sway_view *view,
 			instruction->container_state.content_width == width &&
 			instruction->container_state.content_height == height) {
 		set_instruction_ready(instruction);
+	} else if (view->late_configure &&
+			view->late_configure_geometry.x == (int)x &&
+			view->late_configure_geometry.y == (int)y &&
+			view->late_configure_geometry.width == width &&
+			view->late_configure_geometry.height == height) {
+		view_finish_late_configure(view, true);
 	}
 }
 
-static void _transaction_commit_dirty(bool server_request) {
-	if (!server.dirty_nodes->length) {
-		return;
+static void add_output(list_t *outputs, struct sway_output *output) {
+	if (output && list_find(outputs, output) == -1) {
+		list_add(outputs, output);
 	}
+}
 
-	if (!server.pending_transaction) {
-		server.pending_transaction = transaction_create();
-		if (!server.pending_transaction) {
-			return;
+static void add_workspace_outputs(list_t *outputs, struct sway_workspace *ws) {
+	if (ws) {
+		add_output(outputs, ws->output);
+		add_output(outputs, ws->current.output);
+	}
+}
+
+/**
+ * Collect the outputs a node is shown on, both currently and once pending
+ * changes are applied. Returns false if the node isn't on any output.
+ *
+ * A node in a queued transaction is still shown on the outputs of its current
+ * state, so any later transaction with that node shares an output with the
+ * queued one and waits for it.
+ */
+static bool node_get_outputs(struct sway_node *node, list_t *outputs) {
+	switch (node->type) {
+	case N_ROOT:
+		break;
+	case N_OUTPUT:
+		add_output(outputs, node->sway_output);
+		break;
+	case N_WORKSPACE:
+		add_workspace_outputs(outputs, node->sway_workspace);
+		break;
+	case N_CONTAINER:
+		add_workspace_outputs(outputs, node->sway_container->current.workspace);
+		add_workspace_outputs(outputs, node->sway_container->pending.workspace);
+		break;
+	}
+	return outputs->length > 0;
+}
+
+static void instruction_destroy(
+		struct sway_transaction_instruction *instruction) {
+	switch (instruction->node->type) {
+	case N_ROOT:
+		break;
+	case N_OUTPUT:
+		transaction_list_free(instruction->output_state.workspaces);
+		break;
+	case N_WORKSPACE:
+		transaction_list_free(instruction->workspace_state.floating);
+		transaction_list_free(instruction->workspace_state.tiling);
+		break;
+	case N_CONTAINER:
+		transaction_list_free(instruction->container_state.children);
+		break;
+	}
+	instruction->node->ntxnrefs--;
+	pool_free(instruction_pool, instruction);
+}
+
+/**
+ * Move the nodes of a pending transaction into another one and destroy it.
+ */
+static void transaction_merge(struct sway_transaction *dest,
+		struct sway_transaction *src) {
+	for (int i = 0; i < src->instructions->length; ++i) {
+		struct sway_transaction_instruction *instruction =
+			src->instructions->items[i];
+		// Take the node's latest pending state, which is what the
+		// instruction would have been updated to anyway
+		transaction_add_node(dest, instruction->node,
+			instruction->server_request);
+		instruction_destroy(instruction);
+	}
+	src->instructions->length = 0;
+
+	for (int i = 0; i < src->outputs->length; ++i) {
+		add_output(dest->outputs, src->outputs->items[i]);
+	}
+	dest->global |= src->global;
+	transaction_destroy(src);
+}
+
+/**
+ * Find the pending transaction for a node on the given outputs, merging the
+ * pending transactions it would join together.
+ */
+static struct sway_transaction *get_pending_transaction(list_t *outputs,
+		bool global) {
+	struct sway_transaction *transaction = NULL;
+	for (int i = 0; i < server.pending_transactions->length;) {
+		struct sway_transaction *other =
+			server.pending_transactions->items[i];
+		if (!transaction_conflicts(other, outputs, global)) {
+			++i;
+		} else if (!transaction) {
+			transaction = other;
+			++i;
+		} else {
+			list_del(server.pending_transactions, i);
+			transaction_merge(transaction, other);
+		}
+	}
+
+	if (!transaction) {
+		transaction = transaction_create();
+		if (!transaction) {
+			return NULL;
 		}
+		list_add(server.pending_transactions, transaction);
 	}
+	for (int i = 0; i < outputs->length; ++i) {
+		add_output(transaction->outputs, outputs->items[i]);
+	}
+	transaction->global |= global;
+	return transaction;
+}
 
+static void _transaction_commit_dirty(bool server_request) {
+	if (!server.dirty_nodes->length) {
+		return;
+	}
+
+	// Split the dirty nodes into one transaction per group of outputs, so a
+	// slow client on one output doesn't hold back the others. Nodes sharing
+	// an output end up in the same transaction, which is applied atomically.
+	list_t *outputs = transaction_list_create();
 	for (int i = 0; i < server.dirty_nodes->length; ++i) {
 		struct sway_node *node = server.dirty_nodes->items[i];
-		transaction_add_node(server.pending_transaction, node, server_request);
+		outputs->length = 0;
+		bool global = !node_get_outputs(node, outputs);
+		struct sway_transaction *transaction =
+			get_pending_transaction(outputs, global);
+		if (transaction) {
+			transaction_add_node(transaction, node, server_request);
+		}
 		node->dirty = false;
 	}
 	server.dirty_nodes->length = 0;
+	transaction_list_free(outputs);
 
 	transaction_commit_pending();
 }
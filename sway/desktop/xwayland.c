@@ -618,7 +618,7 @@ static void handle_set_title(struct wl_listener *listener, void *data) {
 	if (!xsurface->mapped) {
 		return;
 	}
-	view_update_title(view, false);
+	view_request_title_update(view);
 	view_execute_criteria(view);
 }
 
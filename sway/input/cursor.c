@@ -346,9 +346,33 @@ void cursor_unhide(struct sway_cursor *cursor) {
 	wl_event_source_timer_update(cursor->hide_source, cursor_get_timeout(cursor));
 }
 
+void cursor_flush_motion(struct sway_cursor *cursor) {
+	if (cursor->motion_idle) {
+		wl_event_source_remove(cursor->motion_idle);
+		cursor->motion_idle = NULL;
+	}
+	if (!cursor->motion_pending) {
+		return;
+	}
+	cursor->motion_pending = false;
+	seatop_pointer_motion(cursor->seat, cursor->motion_time_msec);
+	if (cursor->frame_pending) {
+		cursor->frame_pending = false;
+		wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
+	}
+}
+
+static void handle_motion_idle(void *data) {
+	struct sway_cursor *cursor = data;
+	// The idle source is destroyed once it has been dispatched
+	cursor->motion_idle = NULL;
+	cursor_flush_motion(cursor);
+}
+
 static void pointer_motion(struct sway_cursor *cursor, uint32_t time_msec,
 		struct wlr_input_device *device, double dx, double dy,
 		double dx_unaccel, double dy_unaccel) {
+	// Clients using relative pointer get every event, even when coalescing
 	wlr_relative_pointer_manager_v1_send_relative_motion(
 		server.relative_pointer_manager,
 		cursor->seat->wlr_seat, (uint64_t)time_msec * 1000,
@@ -356,6 +380,8 @@ static void pointer_motion(struct sway_cursor *cursor, uint32_t time_msec,
 
 	// Only apply pointer constraints to real pointer input.
 	if (cursor->active_constraint && device->type == WLR_INPUT_DEVICE_POINTER) {
+		cursor_flush_motion(cursor);
+
 		struct wlr_surface *surface = NULL;
 		double sx, sy;
 		node_at_coords(cursor->seat,
@@ -377,6 +403,20 @@ static void pointer_motion(struct sway_cursor *cursor, uint32_t time_msec,
 
 	wlr_cursor_move(cursor->cursor, device, dx, dy);
 
+	// Confined motion needs the hit test of every event
+	if (cursor->coalesce_motion && !cursor->active_constraint) {
+		cursor->motion_pending = true;
+		cursor->motion_time_msec = time_msec;
+		if (!cursor->motion_idle) {
+			cursor->motion_idle = wl_event_loop_add_idle(
+				server.wl_event_loop, handle_motion_idle, cursor);
+		}
+		if (cursor->motion_idle) {
+			return;
+		}
+		cursor->motion_pending = false;
+	}
+
 	seatop_pointer_motion(cursor->seat, time_msec);
 }
 
@@ -414,6 +454,7 @@ void dispatch_cursor_button(struct sway_cursor *cursor,
 		time_msec = get_current_time_msec();
 	}
 
+	cursor_flush_motion(cursor);
 	seatop_button(cursor->seat, time_msec, device, button, state);
 }
 
@@ -438,6 +479,7 @@ static void handle_pointer_button(struct wl_listener *listener, void *data) {
 
 void dispatch_cursor_axis(struct sway_cursor *cursor,
 		struct wlr_event_pointer_axis *event) {
+	cursor_flush_motion(cursor);
 	seatop_pointer_axis(cursor->seat, event);
 }
 
@@ -450,6 +492,11 @@ static void handle_pointer_axis(struct wl_listener *listener, void *data) {
 
 static void handle_pointer_frame(struct wl_listener *listener, void *data) {
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, frame);
+	if (cursor->motion_pending) {
+		// Sent after the coalesced motion
+		cursor->frame_pending = true;
+		return;
+	}
 	wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
 }
 
@@ -919,6 +966,7 @@ static void handle_pointer_pinch_begin(struct wl_listener *listener, void *data)
 	struct sway_cursor *cursor = wl_container_of(
 			listener, cursor, pinch_begin);
 	struct wlr_event_pointer_pinch_begin *event = data;
+	cursor_flush_motion(cursor);
 	wlr_pointer_gestures_v1_send_pinch_begin(
 			cursor->pointer_gestures, cursor->seat->wlr_seat,
 			event->time_msec, event->fingers);
@@ -947,6 +995,7 @@ static void handle_pointer_swipe_begin(struct wl_listener *listener, void *data)
 	struct sway_cursor *cursor = wl_container_of(
 			listener, cursor, swipe_begin);
 	struct wlr_event_pointer_swipe_begin *event = data;
+	cursor_flush_motion(cursor);
 	wlr_pointer_gestures_v1_send_swipe_begin(
 			cursor->pointer_gestures, cursor->seat->wlr_seat,
 			event->time_msec, event->fingers);
@@ -1039,6 +1088,9 @@ void sway_cursor_destroy(struct sway_cursor *cursor) {
 	}
 
 	wl_event_source_remove(cursor->hide_source);
+	if (cursor->motion_idle) {
+		wl_event_source_remove(cursor->motion_idle);
+	}
 
 	wl_list_remove(&cursor->image_surface_destroy.link);
 	wl_list_remove(&cursor->pinch_begin.link);
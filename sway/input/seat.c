@@ -15,6 +15,7 @@
 #include "config.h"
 #include "list.h"
 #include "log.h"
+#include "pool.h"
 #include "sway/config.h"
 #include "sway/desktop.h"
 #include "sway/input/cursor.h"
@@ -24,6 +25,7 @@
 #include "sway/input/seat.h"
 #include "sway/input/switch.h"
 #include "sway/input/tablet.h"
+#include "sway/ipc-json.h"
 #include "sway/ipc-server.h"
 #include "sway/layers.h"
 #include "sway/output.h"
@@ -34,6 +36,8 @@
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
 
+static pool_t *seat_node_pool = NULL;
+
 static void seat_device_destroy(struct sway_seat_device *seat_device) {
 	if (!seat_device) {
 		return;
@@ -48,10 +52,139 @@ static void seat_device_destroy(struct sway_seat_device *seat_device) {
 	free(seat_device);
 }
 
+/**
+ * The most recently focused descendants of a node for a seat, ie. the first
+ * matching entries of the focus stack. The tiling and floating fields are only
+ * used for workspaces.
+ */
+struct sway_focus_inactive {
+	struct sway_node *node; // Any descendant
+	struct sway_container *view; // Descendant with a view
+	struct sway_node *child; // Direct child, excluding floating containers
+	struct sway_container *tiling; // Descendant in the tiling layout
+	struct sway_container *floating; // Descendant in the floating layout
+};
+
+static struct sway_focus_inactive *focus_inactive_get(struct sway_seat *seat,
+		struct sway_node *node) {
+	struct sway_focus_inactive *entry =
+		hash_table_get_id(seat->focus_inactive, node->id);
+	if (entry) {
+		return entry;
+	}
+	entry = calloc(1, sizeof(struct sway_focus_inactive));
+	if (!sway_assert(entry, "Unable to allocate focus inactive entry")) {
+		return NULL;
+	}
+	list_add(seat->focus_inactive_entries, entry);
+	hash_table_set_id(seat->focus_inactive, node->id, entry);
+	return entry;
+}
+
+static bool is_global_fullscreen(struct sway_node *node) {
+	return node->type == N_CONTAINER &&
+		node->sway_container->pending.fullscreen_mode == FULLSCREEN_GLOBAL;
+}
+
+/**
+ * Records the node in the entries of its ancestors, either as the most recently
+ * focused node or as the least recently focused one, ie. only where no other
+ * node was recorded yet.
+ */
+static void focus_inactive_add(struct sway_seat *seat, struct sway_node *node,
+		bool most_recent) {
+	struct sway_container *con =
+		node->type == N_CONTAINER ? node->sway_container : NULL;
+	struct sway_container *view = con && con->view ? con : NULL;
+	struct sway_node *parent = node_get_parent(node);
+	struct sway_focus_inactive *entry;
+
+	if (parent && (parent->type != N_WORKSPACE ||
+				list_find(parent->sway_workspace->tiling, con) != -1)) {
+		entry = focus_inactive_get(seat, parent);
+		if (entry && (most_recent || !entry->child)) {
+			entry->child = node;
+		}
+	}
+
+	// Global fullscreen containers and their children are descendants of the
+	// root, like in node_has_ancestor
+	bool global = false;
+	struct sway_node *prev = node;
+	for (struct sway_node *ancestor = parent; ancestor;
+			ancestor = node_get_parent(ancestor)) {
+		global = global || is_global_fullscreen(prev);
+		if (!(entry = focus_inactive_get(seat, ancestor))) {
+			return;
+		}
+		bool changed = false;
+		if (most_recent || !entry->node) {
+			entry->node = node;
+			changed = true;
+		}
+		if (view && (most_recent || !entry->view)) {
+			entry->view = view;
+			changed = true;
+		}
+		if (ancestor->type == N_WORKSPACE && con) {
+			struct sway_container **layout =
+				container_is_floating(prev->sway_container) ?
+				&entry->floating : &entry->tiling;
+			if (most_recent || !*layout) {
+				*layout = con;
+				changed = true;
+			}
+		}
+		if (!changed) {
+			// A more recent node already went through the remaining ancestors
+			break;
+		}
+		prev = ancestor;
+	}
+	global = global || is_global_fullscreen(prev);
+
+	if (global && (entry = focus_inactive_get(seat, &root->node))) {
+		if (most_recent || !entry->node) {
+			entry->node = node;
+		}
+		if (view && (most_recent || !entry->view)) {
+			entry->view = view;
+		}
+	}
+}
+
+static void focus_inactive_invalidate(struct sway_seat *seat) {
+	seat->focus_inactive_valid = false;
+}
+
+static bool focus_inactive_is_valid(struct sway_seat *seat) {
+	return seat->focus_inactive_valid &&
+		seat->focus_inactive_serial == root->tree_serial;
+}
+
+static struct sway_focus_inactive *focus_inactive_lookup(
+		struct sway_seat *seat, struct sway_node *node) {
+	if (!focus_inactive_is_valid(seat)) {
+		hash_table_free(seat->focus_inactive);
+		list_free_items_and_destroy(seat->focus_inactive_entries);
+		seat->focus_inactive = create_hash_table();
+		seat->focus_inactive_entries = create_list();
+
+		struct sway_seat_node *current;
+		wl_list_for_each(current, &seat->focus_stack, link) {
+			focus_inactive_add(seat, current->node, false);
+		}
+		seat->focus_inactive_valid = true;
+		seat->focus_inactive_serial = root->tree_serial;
+	}
+	return hash_table_get_id(seat->focus_inactive, node->id);
+}
+
 static void seat_node_destroy(struct sway_seat_node *seat_node) {
+	focus_inactive_invalidate(seat_node->seat);
 	wl_list_remove(&seat_node->destroy.link);
 	wl_list_remove(&seat_node->link);
-	free(seat_node);
+	pool_free(seat_node_pool, seat_node);
 }
 
 void sway_seat_destroy(struct sway_seat *seat) {
@@ -67,6 +200,8 @@ void sway_seat_destroy(struct sway_seat *seat) {
 			link) {
 		seat_node_destroy(seat_node);
 	}
+	hash_table_free(seat->focus_inactive);
+	list_free_items_and_destroy(seat->focus_inactive_entries);
 	sway_input_method_relay_finish(&seat->im_relay);
 	sway_cursor_destroy(seat->cursor);
 	wl_list_remove(&seat->new_node.link);
@@ -213,15 +348,8 @@ struct sway_container *seat_get_focus_inactive_view(struct sway_seat *seat,
 	if (ancestor->type == N_CONTAINER && ancestor->sway_container->view) {
 		return ancestor->sway_container;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node->type == N_CONTAINER && node->sway_container->view &&
-				node_has_ancestor(node, ancestor)) {
-			return node->sway_container;
-		}
-	}
-	return NULL;
+	struct sway_focus_inactive *entry = focus_inactive_lookup(seat, ancestor);
+	return entry ? entry->view : NULL;
 }
 
 static void handle_seat_node_destroy(struct wl_listener *listener, void *data) {
@@ -331,7 +459,10 @@ static struct sway_seat_node *seat_node_from_node(
 		}
 	}
 
-	seat_node = calloc(1, sizeof(struct sway_seat_node));
+	if (!seat_node_pool) {
+		seat_node_pool = create_pool("seat_node", sizeof(struct sway_seat_node));
+	}
+	seat_node = seat_node_pool ? pool_alloc(seat_node_pool) : NULL;
 	if (seat_node == NULL) {
 		sway_log(SWAY_ERROR, "could not allocate seat node");
 		return NULL;
@@ -340,6 +471,9 @@ static struct sway_seat_node *seat_node_from_node(
 	seat_node->node = node;
 	seat_node->seat = seat;
 	wl_list_insert(seat->focus_stack.prev, &seat_node->link);
+	if (focus_inactive_is_valid(seat)) {
+		focus_inactive_add(seat, node, false);
+	}
 	wl_signal_add(&node->events.destroy, &seat_node->destroy);
 	seat_node->destroy.notify = handle_seat_node_destroy;
 
@@ -531,6 +665,7 @@ static void collect_focus_iter(struct sway_node *node, void *data) {
 	}
 	wl_list_remove(&seat_node->link);
 	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	focus_inactive_invalidate(seat);
 }
 
 static void collect_focus_workspace_iter(struct sway_workspace *workspace,
@@ -573,6 +708,8 @@ struct sway_seat *sway_seat_create(const char *seat_name) {
 
 	// init the focus stack
 	wl_list_init(&seat->focus_stack);
+	seat->focus_inactive = create_hash_table();
+	seat->focus_inactive_entries = create_list();
 
 	wl_list_init(&seat->devices);
 
@@ -1097,6 +1234,11 @@ void seat_set_raw_focus(struct sway_seat *seat, struct sway_node *node) {
 	struct sway_seat_node *seat_node = seat_node_from_node(seat, node);
 	wl_list_remove(&seat_node->link);
 	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	if (focus_inactive_is_valid(seat)) {
+		focus_inactive_add(seat, node, true);
+	}
+	// Focus changes the focused, focus and visible fields across the tree
+	ipc_json_invalidate_all();
 	node_set_dirty(node);
 
 	// If focusing a scratchpad container that is fullscreen global, parent
@@ -1131,6 +1273,7 @@ void seat_set_focus(struct sway_seat *seat, struct sway_node *node) {
 		seat_send_unfocus(last_focus, seat);
 		sway_input_method_relay_set_focus(&seat->im_relay, NULL);
 		seat->has_focus = false;
+		ipc_json_invalidate_all();
 		return;
 	}
 
@@ -1240,6 +1383,7 @@ void seat_set_focus(struct sway_seat *seat, struct sway_node *node) {
 	}
 
 	seat->has_focus = true;
+	ipc_json_invalidate_all();
 
 	if (config->smart_gaps && new_workspace) {
 		// When smart gaps is on, gaps may change when the focus changes so
@@ -1264,6 +1408,7 @@ void seat_set_focus_surface(struct sway_seat *seat,
 		struct sway_node *focus = seat_get_focus(seat);
 		seat_send_unfocus(focus, seat);
 		seat->has_focus = false;
+		ipc_json_invalidate_all();
 	}
 
 	if (surface) {
@@ -1343,11 +1488,9 @@ struct sway_node *seat_get_focus_inactive(struct sway_seat *seat,
 	if (node_is_view(node)) {
 		return node;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		if (node_has_ancestor(current->node, node)) {
-			return current->node;
-		}
+	struct sway_focus_inactive *entry = focus_inactive_lookup(seat, node);
+	if (entry && entry->node) {
+		return entry->node;
 	}
 	if (node->type == N_WORKSPACE) {
 		return node;
@@ -1360,16 +1503,9 @@ struct sway_container *seat_get_focus_inactive_tiling(struct sway_seat *seat,
 	if (!workspace->tiling->length) {
 		return NULL;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node->type == N_CONTAINER &&
-				!container_is_floating_or_child(node->sway_container) &&
-				node->sway_container->pending.workspace == workspace) {
-			return node->sway_container;
-		}
-	}
-	return NULL;
+	struct sway_focus_inactive *entry =
+		focus_inactive_lookup(seat, &workspace->node);
+	return entry ? entry->tiling : NULL;
 }
 
 struct sway_container *seat_get_focus_inactive_floating(struct sway_seat *seat,
@@ -1377,16 +1513,9 @@ struct sway_container *seat_get_focus_inactive_floating(struct sway_seat *seat,
 	if (!workspace->floating->length) {
 		return NULL;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node->type == N_CONTAINER &&
-				container_is_floating_or_child(node->sway_container) &&
-				node->sway_container->pending.workspace == workspace) {
-			return node->sway_container;
-		}
-	}
-	return NULL;
+	struct sway_focus_inactive *entry =
+		focus_inactive_lookup(seat, &workspace->node);
+	return entry ? entry->floating : NULL;
 }
 
 struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
@@ -1394,22 +1523,8 @@ struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
 	if (node_is_view(parent)) {
 		return parent;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node_get_parent(node) != parent) {
-			continue;
-		}
-		if (parent->type == N_WORKSPACE) {
-			// Only consider tiling children
-			struct sway_workspace *ws = parent->sway_workspace;
-			if (list_find(ws->tiling, node->sway_container) == -1) {
-				continue;
-			}
-		}
-		return node;
-	}
-	return NULL;
+	struct sway_focus_inactive *entry = focus_inactive_lookup(seat, parent);
+	return entry ? entry->child : NULL;
 }
 
 struct sway_node *seat_get_focus(struct sway_seat *seat) {
@@ -1471,6 +1586,12 @@ void seat_apply_config(struct sway_seat *seat,
 	seat->idle_inhibit_sources = seat_config->idle_inhibit_sources;
 	seat->idle_wake_sources = seat_config->idle_wake_sources;
 
+	seat->cursor->coalesce_motion =
+		seat_config->coalesce_motion == COALESCE_MOTION_ENABLE;
+	if (!seat->cursor->coalesce_motion) {
+		cursor_flush_motion(seat->cursor);
+	}
+
 	wl_list_for_each(seat_device, &seat->devices, link) {
 		seat_configure_device(seat, seat_device->input_device);
 		cursor_handle_activity_from_device(seat->cursor,
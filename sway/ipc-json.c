@@ -5,12 +5,15 @@
 #endif
 #include <libevdev/libevdev.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <wlr/backend/libinput.h>
 #include <wlr/types/wlr_output.h>
 #include <xkbcommon/xkbcommon.h>
 #include "config.h"
 #include "log.h"
 #include "sway/config.h"
+#include "sway/desktop/transaction.h"
 #include "sway/ipc-json.h"
 #include "sway/tree/container.h"
 #include "sway/tree/view.h"
@@ -25,6 +28,40 @@
 static const int i3_output_id = INT32_MAX;
 static const int i3_scratch_id = INT32_MAX - 1;
 
+/**
+ * The serialized description of a node, which embeds those of its children.
+ */
+struct ipc_json_fragment {
+	size_t generation; // Value of cache_generation when it was serialized
+	size_t len;
+	char json[];
+};
+
+// Bumped to invalidate all fragments at once
+static size_t cache_generation = 0;
+
+void ipc_json_node_finish(struct sway_node *node) {
+	free(node->ipc_json);
+	node->ipc_json = NULL;
+}
+
+void ipc_json_invalidate_node(struct sway_node *node) {
+	if (node->type == N_CONTAINER || node->type == N_WORKSPACE) {
+		list_t *children = node_get_children(node);
+		for (int i = 0; children && i < children->length; ++i) {
+			struct sway_container *child = children->items[i];
+			ipc_json_node_finish(&child->node);
+		}
+	}
+	for (; node; node = node_get_parent(node)) {
+		ipc_json_node_finish(node);
+	}
+}
+
+void ipc_json_invalidate_all(void) {
+	cache_generation++;
+}
+
 static const char *ipc_json_node_type_description(enum sway_node_type node_type) {
 	switch (node_type) {
 	case N_ROOT:
@@ -189,232 +226,185 @@ json_object *ipc_json_get_version(void) {
 	return version;
 }
 
-static json_object *ipc_json_create_rect(struct wlr_box *box) {
-	json_object *rect = json_object_new_object();
-
-	json_object_object_add(rect, "x", json_object_new_int(box->x));
-	json_object_object_add(rect, "y", json_object_new_int(box->y));
-	json_object_object_add(rect, "width", json_object_new_int(box->width));
-	json_object_object_add(rect, "height", json_object_new_int(box->height));
-
-	return rect;
+static void write_rect(struct json_writer *writer, const char *key,
+		struct wlr_box *box) {
+	json_writer_key(writer, key);
+	json_writer_object_begin(writer);
+	json_writer_add_int(writer, "x", box->x);
+	json_writer_add_int(writer, "y", box->y);
+	json_writer_add_int(writer, "width", box->width);
+	json_writer_add_int(writer, "height", box->height);
+	json_writer_object_end(writer);
 }
 
-static json_object *ipc_json_create_empty_rect(void) {
+static void write_empty_rect(struct json_writer *writer, const char *key) {
 	struct wlr_box empty = {0, 0, 0, 0};
 
-	return ipc_json_create_rect(&empty);
+	write_rect(writer, key, &empty);
 }
 
-static json_object *ipc_json_create_node(int id, const char* type, char *name,
-		bool focused, json_object *focus, struct wlr_box *box) {
-	json_object *object = json_object_new_object();
+static void write_empty_array(struct json_writer *writer, const char *key) {
+	json_writer_key(writer, key);
+	json_writer_array_begin(writer);
+	json_writer_array_end(writer);
+}
 
-	json_object_object_add(object, "id", json_object_new_int(id));
-	json_object_object_add(object, "type", json_object_new_string(type));
-	json_object_object_add(object, "orientation",
-			json_object_new_string(
-				ipc_json_orientation_description(L_HORIZ)));
-	json_object_object_add(object, "percent", NULL);
-	json_object_object_add(object, "urgent", json_object_new_boolean(false));
-	json_object_object_add(object, "marks", json_object_new_array());
-	json_object_object_add(object, "focused", json_object_new_boolean(focused));
-	json_object_object_add(object, "layout",
-			json_object_new_string(
-				ipc_json_layout_description(L_HORIZ)));
-
-	// set default values to be compatible with i3
-	json_object_object_add(object, "border",
-			json_object_new_string(
-				ipc_json_border_description(B_NONE)));
-	json_object_object_add(object, "current_border_width",
-			json_object_new_int(0));
-	json_object_object_add(object, "rect", ipc_json_create_rect(box));
-	json_object_object_add(object, "deco_rect", ipc_json_create_empty_rect());
-	json_object_object_add(object, "window_rect", ipc_json_create_empty_rect());
-	json_object_object_add(object, "geometry", ipc_json_create_empty_rect());
-	json_object_object_add(object, "name",
-			name ? json_object_new_string(name) : NULL);
-	json_object_object_add(object, "window", NULL);
-	json_object_object_add(object, "nodes", json_object_new_array());
-	json_object_object_add(object, "floating_nodes", json_object_new_array());
-	json_object_object_add(object, "focus", focus);
-	json_object_object_add(object, "fullscreen_mode", json_object_new_int(0));
-	json_object_object_add(object, "sticky", json_object_new_boolean(false));
+/**
+ * Write the members of the nodes faked for compatibility with i3, up to their
+ * children.
+ */
+static void write_i3_node_head(struct json_writer *writer, int id,
+		const char *type, const char *name, const char *layout,
+		struct wlr_box *box) {
+	json_writer_add_int(writer, "id", id);
+	json_writer_add_string(writer, "type", type);
+	json_writer_add_string(writer, "orientation",
+			ipc_json_orientation_description(L_HORIZ));
+	json_writer_add_null(writer, "percent");
+	json_writer_add_bool(writer, "urgent", false);
+	write_empty_array(writer, "marks");
+	json_writer_add_bool(writer, "focused", false);
+	json_writer_add_string(writer, "layout", layout);
+	json_writer_add_string(writer, "border",
+			ipc_json_border_description(B_NONE));
+	json_writer_add_int(writer, "current_border_width", 0);
+	write_rect(writer, "rect", box);
+	write_empty_rect(writer, "deco_rect");
+	write_empty_rect(writer, "window_rect");
+	write_empty_rect(writer, "geometry");
+	json_writer_add_string(writer, "name", name);
+	json_writer_add_null(writer, "window");
+}
 
-	return object;
+static void write_output_modes(struct json_writer *writer,
+		struct wlr_output *wlr_output) {
+	json_writer_key(writer, "modes");
+	json_writer_array_begin(writer);
+	struct wlr_output_mode *mode;
+	wl_list_for_each(mode, &wlr_output->modes, link) {
+		json_writer_object_begin(writer);
+		json_writer_add_int(writer, "width", mode->width);
+		json_writer_add_int(writer, "height", mode->height);
+		json_writer_add_int(writer, "refresh", mode->refresh);
+		json_writer_object_end(writer);
+	}
+	json_writer_array_end(writer);
 }
 
-static void ipc_json_describe_output(struct sway_output *output,
-		json_object *object) {
+static void write_output(struct json_writer *writer,
+		struct sway_output *output, struct sway_workspace *ws) {
 	struct wlr_output *wlr_output = output->wlr_output;
-	json_object_object_add(object, "active", json_object_new_boolean(true));
-	json_object_object_add(object, "dpms",
-			json_object_new_boolean(wlr_output->enabled));
-	json_object_object_add(object, "primary", json_object_new_boolean(false));
-	json_object_object_add(object, "layout", json_object_new_string("output"));
-	json_object_object_add(object, "orientation",
-			json_object_new_string(
-				ipc_json_orientation_description(L_NONE)));
-	json_object_object_add(object, "make",
-			json_object_new_string(wlr_output->make));
-	json_object_object_add(object, "model",
-			json_object_new_string(wlr_output->model));
-	json_object_object_add(object, "serial",
-			json_object_new_string(wlr_output->serial));
-	json_object_object_add(object, "scale",
-			json_object_new_double(wlr_output->scale));
-	json_object_object_add(object, "scale_filter",
-		json_object_new_string(
-			sway_output_scale_filter_to_string(output->scale_filter)));
-	json_object_object_add(object, "transform",
-		json_object_new_string(
-			ipc_json_output_transform_description(wlr_output->transform)));
-	const char *adaptive_sync_status =
-		ipc_json_output_adaptive_sync_status_description(
-			wlr_output->adaptive_sync_status);
-	json_object_object_add(object, "adaptive_sync_status",
-		json_object_new_string(adaptive_sync_status));
-
-	struct sway_workspace *ws = output_get_active_workspace(output);
-	if (!sway_assert(ws, "Expected output to have a workspace")) {
+	json_writer_add_bool(writer, "active", true);
+	json_writer_add_bool(writer, "dpms", wlr_output->enabled);
+	json_writer_add_bool(writer, "primary", false);
+	json_writer_add_string(writer, "make", wlr_output->make);
+	json_writer_add_string(writer, "model", wlr_output->model);
+	json_writer_add_string(writer, "serial", wlr_output->serial);
+	json_writer_add_double(writer, "scale", wlr_output->scale);
+	json_writer_add_string(writer, "scale_filter",
+			sway_output_scale_filter_to_string(output->scale_filter));
+	json_writer_add_string(writer, "transform",
+			ipc_json_output_transform_description(wlr_output->transform));
+	json_writer_add_string(writer, "adaptive_sync_status",
+			ipc_json_output_adaptive_sync_status_description(
+				wlr_output->adaptive_sync_status));
+
+	if (!ws) {
 		return;
 	}
-	json_object_object_add(object, "current_workspace",
-			json_object_new_string(ws->name));
-
-	json_object *modes_array = json_object_new_array();
-	struct wlr_output_mode *mode;
-	wl_list_for_each(mode, &wlr_output->modes, link) {
-		json_object *mode_object = json_object_new_object();
-		json_object_object_add(mode_object, "width",
-			json_object_new_int(mode->width));
-		json_object_object_add(mode_object, "height",
-			json_object_new_int(mode->height));
-		json_object_object_add(mode_object, "refresh",
-			json_object_new_int(mode->refresh));
-		json_object_array_add(modes_array, mode_object);
-	}
-
-	json_object_object_add(object, "modes", modes_array);
-
-	json_object *current_mode_object = json_object_new_object();
-	json_object_object_add(current_mode_object, "width",
-		json_object_new_int(wlr_output->width));
-	json_object_object_add(current_mode_object, "height",
-		json_object_new_int(wlr_output->height));
-	json_object_object_add(current_mode_object, "refresh",
-		json_object_new_int(wlr_output->refresh));
-	json_object_object_add(object, "current_mode", current_mode_object);
-
-	struct sway_node *parent = node_get_parent(&output->node);
-	struct wlr_box parent_box = {0, 0, 0, 0};
+	json_writer_add_string(writer, "current_workspace", ws->name);
 
-	if (parent != NULL) {
-		node_get_box(parent, &parent_box);
-	}
+	write_output_modes(writer, wlr_output);
 
-	if (parent_box.width != 0 && parent_box.height != 0) {
-		double percent = ((double)output->width / parent_box.width)
-				* ((double)output->height / parent_box.height);
-		json_object_object_add(object, "percent", json_object_new_double(percent));
-	}
+	json_writer_key(writer, "current_mode");
+	json_writer_object_begin(writer);
+	json_writer_add_int(writer, "width", wlr_output->width);
+	json_writer_add_int(writer, "height", wlr_output->height);
+	json_writer_add_int(writer, "refresh", wlr_output->refresh);
+	json_writer_object_end(writer);
 
-	json_object_object_add(object, "max_render_time", json_object_new_int(output->max_render_time));
+	json_writer_add_int(writer, "max_render_time", output->max_render_time);
+	json_writer_add_bool(writer, "max_render_time_auto",
+			output->max_render_time_auto);
 }
 
-json_object *ipc_json_describe_disabled_output(struct sway_output *output) {
+void ipc_json_write_disabled_output(struct json_writer *writer,
+		struct sway_output *output) {
 	struct wlr_output *wlr_output = output->wlr_output;
 
-	json_object *object = json_object_new_object();
+	json_writer_object_begin(writer);
 
-	json_object_object_add(object, "type", json_object_new_string("output"));
-	json_object_object_add(object, "name",
-			json_object_new_string(wlr_output->name));
-	json_object_object_add(object, "active", json_object_new_boolean(false));
-	json_object_object_add(object, "dpms", json_object_new_boolean(false));
-	json_object_object_add(object, "primary", json_object_new_boolean(false));
-	json_object_object_add(object, "make",
-			json_object_new_string(wlr_output->make));
-	json_object_object_add(object, "model",
-			json_object_new_string(wlr_output->model));
-	json_object_object_add(object, "serial",
-			json_object_new_string(wlr_output->serial));
-
-	json_object *modes_array = json_object_new_array();
-	struct wlr_output_mode *mode;
-	wl_list_for_each(mode, &wlr_output->modes, link) {
-		json_object *mode_object = json_object_new_object();
-		json_object_object_add(mode_object, "width",
-			json_object_new_int(mode->width));
-		json_object_object_add(mode_object, "height",
-			json_object_new_int(mode->height));
-		json_object_object_add(mode_object, "refresh",
-			json_object_new_int(mode->refresh));
-		json_object_array_add(modes_array, mode_object);
-	}
-
-	json_object_object_add(object, "modes", modes_array);
+	json_writer_add_string(writer, "type", "output");
+	json_writer_add_string(writer, "name", wlr_output->name);
+	json_writer_add_bool(writer, "active", false);
+	json_writer_add_bool(writer, "dpms", false);
+	json_writer_add_bool(writer, "primary", false);
+	json_writer_add_string(writer, "make", wlr_output->make);
+	json_writer_add_string(writer, "model", wlr_output->model);
+	json_writer_add_string(writer, "serial", wlr_output->serial);
 
-	json_object_object_add(object, "current_workspace", NULL);
+	write_output_modes(writer, wlr_output);
 
-	json_object *rect_object = json_object_new_object();
-	json_object_object_add(rect_object, "x", json_object_new_int(0));
-	json_object_object_add(rect_object, "y", json_object_new_int(0));
-	json_object_object_add(rect_object, "width", json_object_new_int(0));
-	json_object_object_add(rect_object, "height", json_object_new_int(0));
-	json_object_object_add(object, "rect", rect_object);
+	json_writer_add_null(writer, "current_workspace");
+	write_empty_rect(writer, "rect");
+	json_writer_add_null(writer, "percent");
 
-	json_object_object_add(object, "percent", NULL);
-
-	return object;
+	json_writer_object_end(writer);
 }
 
-static json_object *ipc_json_describe_scratchpad_output(void) {
+static void write_scratchpad_output(struct json_writer *writer) {
 	struct wlr_box box;
 	root_get_box(root, &box);
 
-	// Create focus stack for __i3_scratch workspace
-	json_object *workspace_focus = json_object_new_array();
-	for (int i = root->scratchpad->length - 1; i >= 0; --i) {
-		struct sway_container *container = root->scratchpad->items[i];
-		json_object_array_add(workspace_focus,
-				json_object_new_int(container->node.id));
-	}
+	json_writer_object_begin(writer);
+	write_i3_node_head(writer, i3_output_id, "output", "__i3", "output", &box);
+	json_writer_key(writer, "nodes");
+	json_writer_array_begin(writer);
 
-	json_object *workspace = ipc_json_create_node(i3_scratch_id, "workspace",
-				"__i3_scratch", false, workspace_focus, &box);
-	json_object_object_add(workspace, "fullscreen_mode", json_object_new_int(1));
+	json_writer_object_begin(writer);
+	write_i3_node_head(writer, i3_scratch_id, "workspace", "__i3_scratch",
+			ipc_json_layout_description(L_HORIZ), &box);
+	write_empty_array(writer, "nodes");
 
 	// List all hidden scratchpad containers as floating nodes
-	json_object *floating_array = json_object_new_array();
+	json_writer_key(writer, "floating_nodes");
+	json_writer_array_begin(writer);
 	for (int i = 0; i < root->scratchpad->length; ++i) {
 		struct sway_container *container = root->scratchpad->items[i];
 		if (container_is_scratchpad_hidden(container)) {
-			json_object_array_add(floating_array,
-				ipc_json_describe_node_recursive(&container->node));
+			ipc_json_write_node_recursive(writer, &container->node);
 		}
 	}
-	json_object_object_add(workspace, "floating_nodes", floating_array);
-
-	// Create focus stack for __i3 output
-	json_object *output_focus = json_object_new_array();
-	json_object_array_add(output_focus, json_object_new_int(i3_scratch_id));
-
-	json_object *output = ipc_json_create_node(i3_output_id, "output",
-					"__i3", false, output_focus, &box);
-	json_object_object_add(output, "layout",
-			json_object_new_string("output"));
+	json_writer_array_end(writer);
 
-	json_object *nodes = json_object_new_array();
-	json_object_array_add(nodes, workspace);
-	json_object_object_add(output, "nodes", nodes);
-
-	return output;
+	// Focus stack for the __i3_scratch workspace
+	json_writer_key(writer, "focus");
+	json_writer_array_begin(writer);
+	for (int i = root->scratchpad->length - 1; i >= 0; --i) {
+		struct sway_container *container = root->scratchpad->items[i];
+		json_writer_int(writer, (int)container->node.id);
+	}
+	json_writer_array_end(writer);
+	json_writer_add_int(writer, "fullscreen_mode", 1);
+	json_writer_add_bool(writer, "sticky", false);
+	json_writer_object_end(writer);
+
+	json_writer_array_end(writer);
+	write_empty_array(writer, "floating_nodes");
+
+	// Focus stack for the __i3 output
+	json_writer_key(writer, "focus");
+	json_writer_array_begin(writer);
+	json_writer_int(writer, i3_scratch_id);
+	json_writer_array_end(writer);
+	json_writer_add_int(writer, "fullscreen_mode", 0);
+	json_writer_add_bool(writer, "sticky", false);
+
+	json_writer_object_end(writer);
 }
 
-static void ipc_json_describe_workspace(struct sway_workspace *workspace,
-		json_object *object) {
+static void write_workspace(struct json_writer *writer,
+		struct sway_workspace *workspace) {
 	int num;
 	if (isdigit(workspace->name[0])) {
 		errno = 0;
@@ -428,30 +418,11 @@ static void ipc_json_describe_workspace(struct sway_workspace *workspace,
 	} else {
 		num = -1;
 	}
-	json_object_object_add(object, "num", json_object_new_int(num));
-	json_object_object_add(object, "fullscreen_mode", json_object_new_int(1));
-	json_object_object_add(object, "output", workspace->output ?
-			json_object_new_string(workspace->output->wlr_output->name) : NULL);
-	json_object_object_add(object, "urgent",
-			json_object_new_boolean(workspace->urgent));
-	json_object_object_add(object, "representation", workspace->representation ?
-			json_object_new_string(workspace->representation) : NULL);
-
-	json_object_object_add(object, "layout",
-			json_object_new_string(
-				ipc_json_layout_description(workspace->layout)));
-	json_object_object_add(object, "orientation",
-			json_object_new_string(
-				ipc_json_orientation_description(workspace->layout)));
-
-	// Floating
-	json_object *floating_array = json_object_new_array();
-	for (int i = 0; i < workspace->floating->length; ++i) {
-		struct sway_container *floater = workspace->floating->items[i];
-		json_object_array_add(floating_array,
-				ipc_json_describe_node_recursive(&floater->node));
-	}
-	json_object_object_add(object, "floating_nodes", floating_array);
+	json_writer_add_int(writer, "num", num);
+	json_writer_add_string(writer, "output", workspace->output ?
+			workspace->output->wlr_output->name : NULL);
+	json_writer_add_string(writer, "representation",
+			workspace->representation);
 }
 #endif
 
@@ -493,264 +464,164 @@ static void get_deco_rect(struct sway_container *c, struct wlr_box *deco_rect) {
 }
 
 #ifdef HAVE_JSON
-static void ipc_json_describe_view(struct sway_container *c, json_object *object) {
-	json_object_object_add(object, "pid", json_object_new_int(c->view->pid));
-
-	const char *app_id = view_get_app_id(c->view);
-	json_object_object_add(object, "app_id",
-			app_id ? json_object_new_string(app_id) : NULL);
-
-	bool visible = view_is_visible(c->view);
-	json_object_object_add(object, "visible", json_object_new_boolean(visible));
-
-	struct wlr_box window_box = {
-		c->pending.content_x - c->pending.x,
-		(c->current.border == B_PIXEL) ? c->current.border_thickness : 0,
-		c->pending.content_width,
-		c->pending.content_height
-	};
-
-	json_object_object_add(object, "window_rect", ipc_json_create_rect(&window_box));
-
-	struct wlr_box geometry = {0, 0, c->view->natural_width, c->view->natural_height};
-	json_object_object_add(object, "geometry", ipc_json_create_rect(&geometry));
-
-	json_object_object_add(object, "max_render_time", json_object_new_int(c->view->max_render_time));
+static void write_view(struct json_writer *writer, struct sway_view *view) {
+	json_writer_add_int(writer, "pid", view->pid);
+	json_writer_add_string(writer, "app_id", view_get_app_id(view));
+	json_writer_add_bool(writer, "visible", view_is_visible(view));
+	json_writer_add_int(writer, "max_render_time", view->max_render_time);
+
+	struct sway_client_latency_stats latency;
+	if (transaction_get_view_latency(view, &latency)) {
+		json_writer_key(writer, "configure_latency");
+		json_writer_object_begin(writer);
+		json_writer_add_double(writer, "average", latency.ema_ms);
+		json_writer_add_double(writer, "p95", latency.p95_ms);
+		json_writer_add_int(writer, "samples", latency.samples);
+		json_writer_add_int(writer, "timeouts", latency.timeouts);
+		json_writer_add_bool(writer, "slow", latency.slow);
+		json_writer_object_end(writer);
+	}
 
-	json_object_object_add(object, "shell", json_object_new_string(view_get_shell(c->view)));
+	json_writer_add_string(writer, "shell", view_get_shell(view));
 
-	json_object_object_add(object, "inhibit_idle",
-		json_object_new_boolean(view_inhibit_idle(c->view)));
+	json_writer_add_bool(writer, "inhibit_idle", view_inhibit_idle(view));
 
-	json_object *idle_inhibitors = json_object_new_object();
+	json_writer_key(writer, "idle_inhibitors");
+	json_writer_object_begin(writer);
 
 	struct sway_idle_inhibitor_v1 *user_inhibitor =
-		sway_idle_inhibit_v1_user_inhibitor_for_view(c->view);
+		sway_idle_inhibit_v1_user_inhibitor_for_view(view);
 
-	if (user_inhibitor) {
-		json_object_object_add(idle_inhibitors, "user",
-			json_object_new_string(
-				ipc_json_user_idle_inhibitor_description(user_inhibitor->mode)));
-	} else {
-		json_object_object_add(idle_inhibitors, "user",
-			json_object_new_string("none"));
-	}
+	json_writer_add_string(writer, "user", user_inhibitor ?
+			ipc_json_user_idle_inhibitor_description(user_inhibitor->mode) :
+			"none");
 
 	struct sway_idle_inhibitor_v1 *application_inhibitor =
-		sway_idle_inhibit_v1_application_inhibitor_for_view(c->view);
+		sway_idle_inhibit_v1_application_inhibitor_for_view(view);
 
-	if (application_inhibitor) {
-		json_object_object_add(idle_inhibitors, "application",
-			json_object_new_string("enabled"));
-	} else {
-		json_object_object_add(idle_inhibitors, "application",
-			json_object_new_string("none"));
-	}
+	json_writer_add_string(writer, "application",
+			application_inhibitor ? "enabled" : "none");
 
-	json_object_object_add(object, "idle_inhibitors", idle_inhibitors);
+	json_writer_object_end(writer);
 
 #if HAVE_XWAYLAND
-	if (c->view->type == SWAY_VIEW_XWAYLAND) {
-		json_object_object_add(object, "window",
-				json_object_new_int(view_get_x11_window_id(c->view)));
+	if (view->type == SWAY_VIEW_XWAYLAND) {
+		json_writer_key(writer, "window_properties");
+		json_writer_object_begin(writer);
 
-		json_object *window_props = json_object_new_object();
-
-		const char *class = view_get_class(c->view);
+		const char *class = view_get_class(view);
 		if (class) {
-			json_object_object_add(window_props, "class", json_object_new_string(class));
+			json_writer_add_string(writer, "class", class);
 		}
-		const char *instance = view_get_instance(c->view);
+		const char *instance = view_get_instance(view);
 		if (instance) {
-			json_object_object_add(window_props, "instance", json_object_new_string(instance));
+			json_writer_add_string(writer, "instance", instance);
 		}
-		if (c->title) {
-			json_object_object_add(window_props, "title", json_object_new_string(c->title));
+		if (view->container->title) {
+			json_writer_add_string(writer, "title", view->container->title);
 		}
 
 		// the transient_for key is always present in i3's output
-		uint32_t parent_id = view_get_x11_parent_id(c->view);
-		json_object_object_add(window_props, "transient_for",
-				parent_id ? json_object_new_int(parent_id) : NULL);
+		uint32_t parent_id = view_get_x11_parent_id(view);
+		if (parent_id) {
+			json_writer_add_int(writer, "transient_for", (int)parent_id);
+		} else {
+			json_writer_add_null(writer, "transient_for");
+		}
 
-		const char *role = view_get_window_role(c->view);
+		const char *role = view_get_window_role(view);
 		if (role) {
-			json_object_object_add(window_props, "window_role", json_object_new_string(role));
+			json_writer_add_string(writer, "window_role", role);
 		}
 
-		uint32_t window_type = view_get_window_type(c->view);
+		uint32_t window_type = view_get_window_type(view);
 		if (window_type) {
-			json_object_object_add(window_props, "window_type",
-				json_object_new_string(
-					ipc_json_xwindow_type_description(c->view)));
+			json_writer_add_string(writer, "window_type",
+					ipc_json_xwindow_type_description(view));
 		}
 
-		json_object_object_add(object, "window_properties", window_props);
+		json_writer_object_end(writer);
 	}
 #endif
 }
 
-static void ipc_json_describe_container(struct sway_container *c, json_object *object) {
-	json_object_object_add(object, "name",
-			c->title ? json_object_new_string(c->title) : NULL);
-	if (container_is_floating(c)) {
-		json_object_object_add(object, "type",
-				json_object_new_string("floating_con"));
-	}
-
-	json_object_object_add(object, "layout",
-			json_object_new_string(
-				ipc_json_layout_description(c->pending.layout)));
-
-	json_object_object_add(object, "orientation",
-			json_object_new_string(
-				ipc_json_orientation_description(c->pending.layout)));
-
-	bool urgent = c->view ?
-		view_is_urgent(c->view) : container_has_urgent_child(c);
-	json_object_object_add(object, "urgent", json_object_new_boolean(urgent));
-	json_object_object_add(object, "sticky", json_object_new_boolean(c->is_sticky));
-
-	json_object_object_add(object, "fullscreen_mode",
-			json_object_new_int(c->pending.fullscreen_mode));
-
-	struct sway_node *parent = node_get_parent(&c->node);
-	struct wlr_box parent_box = {0, 0, 0, 0};
-
-	if (parent != NULL) {
-		node_get_box(parent, &parent_box);
-	}
-
-	if (parent_box.width != 0 && parent_box.height != 0) {
-		double percent = ((double)c->pending.width / parent_box.width)
-				* ((double)c->pending.height / parent_box.height);
-		json_object_object_add(object, "percent", json_object_new_double(percent));
-	}
-
-	json_object_object_add(object, "border",
-			json_object_new_string(
-				ipc_json_border_description(c->current.border)));
-	json_object_object_add(object, "current_border_width",
-			json_object_new_int(c->current.border_thickness));
-	json_object_object_add(object, "floating_nodes", json_object_new_array());
-
-	struct wlr_box deco_box = {0, 0, 0, 0};
-	get_deco_rect(c, &deco_box);
-	json_object_object_add(object, "deco_rect", ipc_json_create_rect(&deco_box));
-
-	json_object *marks = json_object_new_array();
-	list_t *con_marks = c->marks;
-	for (int i = 0; i < con_marks->length; ++i) {
-		json_object_array_add(marks, json_object_new_string(con_marks->items[i]));
-	}
-
-	json_object_object_add(object, "marks", marks);
-
-	if (c->view) {
-		ipc_json_describe_view(c, object);
-	}
-}
-
 struct focus_inactive_data {
 	struct sway_node *node;
-	json_object *object;
+	struct json_writer *writer;
+	list_t *outputs; // Outputs already listed in the focus of the root
 };
 
 static void focus_inactive_children_iterator(struct sway_node *node,
 		void *_data) {
 	struct focus_inactive_data *data = _data;
-	json_object *focus = data->object;
 	if (data->node == &root->node) {
 		struct sway_output *output = node_get_output(node);
-		if (output == NULL) {
+		if (output == NULL || list_find(data->outputs, output) != -1) {
 			return;
 		}
-		size_t id = output->node.id;
-		int len = json_object_array_length(focus);
-		for (int i = 0; i < len; ++i) {
-			if ((size_t) json_object_get_int(json_object_array_get_idx(focus, i)) == id) {
-				return;
-			}
-		}
+		list_add(data->outputs, output);
 		node = &output->node;
 	} else if (node_get_parent(node) != data->node) {
 		return;
 	}
-	json_object_array_add(focus, json_object_new_int(node->id));
+	json_writer_int(data->writer, (int)node->id);
 }
 
-json_object *ipc_json_describe_node(struct sway_node *node) {
+static void write_focus(struct json_writer *writer, struct sway_node *node) {
 	struct sway_seat *seat = input_manager_get_default_seat();
-	bool focused = seat_get_focus(seat) == node;
-	char *name = node_get_name(node);
-
-	struct wlr_box box;
-	node_get_box(node, &box);
-	if (node->type == N_CONTAINER) {
-		struct wlr_box deco_rect = {0, 0, 0, 0};
-		get_deco_rect(node->sway_container, &deco_rect);
-		size_t count = 1;
-		if (container_parent_layout(node->sway_container) == L_STACKED) {
-			count = container_get_siblings(node->sway_container)->length;
-		}
-		box.y += deco_rect.height * count;
-		box.height -= deco_rect.height * count;
-	}
-
-	json_object *focus = json_object_new_array();
 	struct focus_inactive_data data = {
 		.node = node,
-		.object = focus,
+		.writer = writer,
+		.outputs = node->type == N_ROOT ? create_list() : NULL,
 	};
+	json_writer_key(writer, "focus");
+	json_writer_array_begin(writer);
 	seat_for_each_node(seat, focus_inactive_children_iterator, &data);
+	json_writer_array_end(writer);
+	list_free(data.outputs);
+}
 
-	json_object *object = ipc_json_create_node((int)node->id,
-				ipc_json_node_type_description(node->type), name, focused, focus, &box);
+/**
+ * The share of the parent's area covered by the node.
+ */
+static bool get_percent(struct sway_node *node, double *percent) {
+	struct sway_node *parent = node_get_parent(node);
+	struct wlr_box parent_box = {0, 0, 0, 0};
 
-	switch (node->type) {
-	case N_ROOT:
-		break;
-	case N_OUTPUT:
-		ipc_json_describe_output(node->sway_output, object);
-		break;
-	case N_CONTAINER:
-		ipc_json_describe_container(node->sway_container, object);
-		break;
-	case N_WORKSPACE:
-		ipc_json_describe_workspace(node->sway_workspace, object);
-		break;
+	if (parent != NULL) {
+		node_get_box(parent, &parent_box);
 	}
 
-	return object;
+	if (parent_box.width == 0 || parent_box.height == 0) {
+		return false;
+	}
+	struct wlr_box box;
+	node_get_box(node, &box);
+	*percent = ((double)box.width / parent_box.width)
+			* ((double)box.height / parent_box.height);
+	return true;
 }
 
-json_object *ipc_json_describe_node_recursive(struct sway_node *node) {
-	json_object *object = ipc_json_describe_node(node);
+static void write_children(struct json_writer *writer, struct sway_node *node) {
 	int i;
-
-	json_object *children = json_object_new_array();
 	switch (node->type) {
 	case N_ROOT:
-		json_object_array_add(children,
-				ipc_json_describe_scratchpad_output());
+		write_scratchpad_output(writer);
 		for (i = 0; i < root->outputs->length; ++i) {
 			struct sway_output *output = root->outputs->items[i];
-			json_object_array_add(children,
-					ipc_json_describe_node_recursive(&output->node));
+			ipc_json_write_node_recursive(writer, &output->node);
 		}
 		break;
 	case N_OUTPUT:
 		for (i = 0; i < node->sway_output->workspaces->length; ++i) {
 			struct sway_workspace *ws = node->sway_output->workspaces->items[i];
-			json_object_array_add(children,
-					ipc_json_describe_node_recursive(&ws->node));
+			ipc_json_write_node_recursive(writer, &ws->node);
 		}
 		break;
 	case N_WORKSPACE:
 		for (i = 0; i < node->sway_workspace->tiling->length; ++i) {
 			struct sway_container *con = node->sway_workspace->tiling->items[i];
-			json_object_array_add(children,
-					ipc_json_describe_node_recursive(&con->node));
+			ipc_json_write_node_recursive(writer, &con->node);
 		}
 		break;
 	case N_CONTAINER:
@@ -758,19 +629,195 @@ json_object *ipc_json_describe_node_recursive(struct sway_node *node) {
 			for (i = 0; i < node->sway_container->pending.children->length; ++i) {
 				struct sway_container *child =
 					node->sway_container->pending.children->items[i];
-				json_object_array_add(children,
-						ipc_json_describe_node_recursive(&child->node));
+				ipc_json_write_node_recursive(writer, &child->node);
 			}
 		}
 		break;
 	}
-	json_object_object_add(object, "nodes", children);
+}
 
-	return object;
+void ipc_json_write_node_members(struct json_writer *writer,
+		struct sway_node *node, bool recursive, bool focused) {
+	struct sway_output *output =
+		node->type == N_OUTPUT ? node->sway_output : NULL;
+	struct sway_workspace *ws =
+		node->type == N_WORKSPACE ? node->sway_workspace : NULL;
+	struct sway_container *con =
+		node->type == N_CONTAINER ? node->sway_container : NULL;
+	struct sway_view *view = con ? con->view : NULL;
+
+	struct sway_workspace *output_ws = NULL;
+	if (output) {
+		output_ws = output_get_active_workspace(output);
+		sway_assert(output_ws, "Expected output to have a workspace");
+	}
+
+	struct wlr_box box;
+	node_get_box(node, &box);
+	struct wlr_box deco_rect = {0, 0, 0, 0};
+	if (con) {
+		get_deco_rect(con, &deco_rect);
+		size_t count = 1;
+		if (container_parent_layout(con) == L_STACKED) {
+			count = container_get_siblings(con)->length;
+		}
+		box.y += deco_rect.height * count;
+		box.height -= deco_rect.height * count;
+	}
+
+	const char *type = ipc_json_node_type_description(node->type);
+	const char *layout = ipc_json_layout_description(L_HORIZ);
+	const char *orientation = ipc_json_orientation_description(L_HORIZ);
+	bool urgent = false;
+	int fullscreen_mode = 0;
+	if (output) {
+		layout = "output";
+		orientation = ipc_json_orientation_description(L_NONE);
+	} else if (ws) {
+		layout = ipc_json_layout_description(ws->layout);
+		orientation = ipc_json_orientation_description(ws->layout);
+		urgent = ws->urgent;
+		fullscreen_mode = 1;
+	} else if (con) {
+		if (container_is_floating(con)) {
+			type = "floating_con";
+		}
+		layout = ipc_json_layout_description(con->pending.layout);
+		orientation = ipc_json_orientation_description(con->pending.layout);
+		urgent = view ? view_is_urgent(view) : container_has_urgent_child(con);
+		fullscreen_mode = con->pending.fullscreen_mode;
+	}
+
+	json_writer_add_int(writer, "id", (int)node->id);
+	json_writer_add_string(writer, "type", type);
+	json_writer_add_string(writer, "orientation", orientation);
+
+	double percent;
+	if ((con || output_ws) && get_percent(node, &percent)) {
+		json_writer_add_double(writer, "percent", percent);
+	} else {
+		json_writer_add_null(writer, "percent");
+	}
+
+	json_writer_add_bool(writer, "urgent", urgent);
+
+	json_writer_key(writer, "marks");
+	json_writer_array_begin(writer);
+	for (int i = 0; con && i < con->marks->length; ++i) {
+		json_writer_string(writer, con->marks->items[i]);
+	}
+	json_writer_array_end(writer);
+
+	if (focused) {
+		struct sway_seat *seat = input_manager_get_default_seat();
+		json_writer_add_bool(writer, "focused", seat_get_focus(seat) == node);
+	}
+	json_writer_add_string(writer, "layout", layout);
+	json_writer_add_string(writer, "border", ipc_json_border_description(
+				con ? con->current.border : B_NONE));
+	json_writer_add_int(writer, "current_border_width",
+			con ? con->current.border_thickness : 0);
+	write_rect(writer, "rect", &box);
+	write_rect(writer, "deco_rect", &deco_rect);
+
+	if (view) {
+		struct wlr_box window_box = {
+			con->pending.content_x - con->pending.x,
+			(con->current.border == B_PIXEL) ? con->current.border_thickness : 0,
+			con->pending.content_width,
+			con->pending.content_height
+		};
+		write_rect(writer, "window_rect", &window_box);
+
+		struct wlr_box geometry = {0, 0, view->natural_width, view->natural_height};
+		write_rect(writer, "geometry", &geometry);
+	} else {
+		write_empty_rect(writer, "window_rect");
+		write_empty_rect(writer, "geometry");
+	}
+
+	json_writer_add_string(writer, "name", node_get_name(node));
+
+#if HAVE_XWAYLAND
+	if (view && view->type == SWAY_VIEW_XWAYLAND) {
+		json_writer_add_int(writer, "window",
+				(int)view_get_x11_window_id(view));
+	} else {
+		json_writer_add_null(writer, "window");
+	}
+#else
+	json_writer_add_null(writer, "window");
+#endif
+
+	json_writer_key(writer, "nodes");
+	json_writer_array_begin(writer);
+	if (recursive) {
+		write_children(writer, node);
+	}
+	json_writer_array_end(writer);
+
+	json_writer_key(writer, "floating_nodes");
+	json_writer_array_begin(writer);
+	for (int i = 0; ws && i < ws->floating->length; ++i) {
+		struct sway_container *floater = ws->floating->items[i];
+		ipc_json_write_node_recursive(writer, &floater->node);
+	}
+	json_writer_array_end(writer);
+
+	write_focus(writer, node);
+	json_writer_add_int(writer, "fullscreen_mode", fullscreen_mode);
+	json_writer_add_bool(writer, "sticky", con && con->is_sticky);
+
+	if (output) {
+		write_output(writer, output, output_ws);
+	} else if (ws) {
+		write_workspace(writer, ws);
+	} else if (view) {
+		write_view(writer, view);
+	}
 }
 
-static json_object *describe_libinput_device(struct libinput_device *device) {
-	json_object *object = json_object_new_object();
+void ipc_json_write_node(struct json_writer *writer, struct sway_node *node) {
+	json_writer_object_begin(writer);
+	ipc_json_write_node_members(writer, node, false, true);
+	json_writer_object_end(writer);
+}
+
+void ipc_json_write_node_recursive(struct json_writer *writer,
+		struct sway_node *node) {
+	bool cacheable = node->type == N_CONTAINER || node->type == N_WORKSPACE;
+	struct ipc_json_fragment *fragment = node->ipc_json;
+	if (cacheable && fragment && fragment->generation == cache_generation) {
+		json_writer_raw(writer, fragment->json, fragment->len);
+		return;
+	}
+
+	json_writer_object_begin(writer);
+	// The fragment starts at the opening brace, after any separator
+	size_t start = writer->len - 1;
+	ipc_json_write_node_members(writer, node, true, true);
+	json_writer_object_end(writer);
+	if (!cacheable || writer->failed) {
+		return;
+	}
+
+	// Children are embedded from their own fragments
+	ipc_json_node_finish(node);
+	size_t len = writer->len - start;
+	fragment = malloc(sizeof(struct ipc_json_fragment) + len);
+	if (!fragment) {
+		sway_log(SWAY_ERROR, "Unable to allocate JSON fragment");
+		return;
+	}
+	fragment->generation = cache_generation;
+	fragment->len = len;
+	memcpy(fragment->json, writer->data + start, len);
+	node->ipc_json = fragment;
+}
+
+static void write_libinput_device(struct json_writer *writer,
+		struct libinput_device *device) {
+	json_writer_object_begin(writer);
 
 	const char *events = "unknown";
 	switch (libinput_device_config_send_events_get_mode(device)) {
@@ -784,8 +831,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 		events = "disabled";
 		break;
 	}
-	json_object_object_add(object, "send_events",
-			json_object_new_string(events));
+	json_writer_add_string(writer, "send_events", events);
 
 	if (libinput_device_config_tap_get_finger_count(device) > 0) {
 		const char *tap = "unknown";
@@ -797,7 +843,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			tap = "disabled";
 			break;
 		}
-		json_object_object_add(object, "tap", json_object_new_string(tap));
+		json_writer_add_string(writer, "tap", tap);
 
 		const char *button_map = "unknown";
 		switch (libinput_device_config_tap_get_button_map(device)) {
@@ -808,8 +854,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			button_map = "lmr";
 			break;
 		}
-		json_object_object_add(object, "tap_button_map",
-				json_object_new_string(button_map));
+		json_writer_add_string(writer, "tap_button_map", button_map);
 
 		const char* drag = "unknown";
 		switch (libinput_device_config_tap_get_drag_enabled(device)) {
@@ -820,8 +865,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			drag = "disabled";
 			break;
 		}
-		json_object_object_add(object, "tap_drag",
-				json_object_new_string(drag));
+		json_writer_add_string(writer, "tap_drag", drag);
 
 		const char *drag_lock = "unknown";
 		switch (libinput_device_config_tap_get_drag_lock_enabled(device)) {
@@ -832,14 +876,12 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			drag_lock = "disabled";
 			break;
 		}
-		json_object_object_add(object, "tap_drag_lock",
-				json_object_new_string(drag_lock));
+		json_writer_add_string(writer, "tap_drag_lock", drag_lock);
 	}
 
 	if (libinput_device_config_accel_is_available(device)) {
 		double accel = libinput_device_config_accel_get_speed(device);
-		json_object_object_add(object, "accel_speed",
-				json_object_new_double(accel));
+		json_writer_add_double(writer, "accel_speed", accel);
 
 		const char *accel_profile = "unknown";
 		switch (libinput_device_config_accel_get_profile(device)) {
@@ -853,8 +895,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			accel_profile = "adaptive";
 			break;
 		}
-		json_object_object_add(object, "accel_profile",
-				json_object_new_string(accel_profile));
+		json_writer_add_string(writer, "accel_profile", accel_profile);
 	}
 
 	if (libinput_device_config_scroll_has_natural_scroll(device)) {
@@ -862,8 +903,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 		if (libinput_device_config_scroll_get_natural_scroll_enabled(device)) {
 			natural_scroll = "enabled";
 		}
-		json_object_object_add(object, "natural_scroll",
-				json_object_new_string(natural_scroll));
+		json_writer_add_string(writer, "natural_scroll", natural_scroll);
 	}
 
 	if (libinput_device_config_left_handed_is_available(device)) {
@@ -871,8 +911,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 		if (libinput_device_config_left_handed_get(device) != 0) {
 			left_handed = "enabled";
 		}
-		json_object_object_add(object, "left_handed",
-				json_object_new_string(left_handed));
+		json_writer_add_string(writer, "left_handed", left_handed);
 	}
 
 	uint32_t click_methods = libinput_device_config_click_get_methods(device);
@@ -889,8 +928,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			click_method = "clickfinger";
 			break;
 		}
-		json_object_object_add(object, "click_method",
-				json_object_new_string(click_method));
+		json_writer_add_string(writer, "click_method", click_method);
 	}
 
 	if (libinput_device_config_middle_emulation_is_available(device)) {
@@ -903,8 +941,7 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			middle_emulation = "disabled";
 			break;
 		}
-		json_object_object_add(object, "middle_emulation",
-				json_object_new_string(middle_emulation));
+		json_writer_add_string(writer, "middle_emulation", middle_emulation);
 	}
 
 	uint32_t scroll_methods = libinput_device_config_scroll_get_methods(device);
@@ -924,13 +961,11 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			scroll_method = "on_button_down";
 			break;
 		}
-		json_object_object_add(object, "scroll_method",
-				json_object_new_string(scroll_method));
+		json_writer_add_string(writer, "scroll_method", scroll_method);
 
 		if ((scroll_methods & LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN) != 0) {
 			uint32_t button = libinput_device_config_scroll_get_button(device);
-			json_object_object_add(object, "scroll_button",
-					json_object_new_int(button));
+			json_writer_add_int(writer, "scroll_button", button);
 		}
 	}
 
@@ -944,67 +979,69 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 			dwt = "disabled";
 			break;
 		}
-		json_object_object_add(object, "dwt", json_object_new_string(dwt));
+		json_writer_add_string(writer, "dwt", dwt);
 	}
 
 	if (libinput_device_config_calibration_has_matrix(device)) {
 		float matrix[6];
 		libinput_device_config_calibration_get_matrix(device, matrix);
-		struct json_object* array = json_object_new_array();
-		struct json_object* x;
+		json_writer_key(writer, "calibration_matrix");
+		json_writer_array_begin(writer);
 		for (int i = 0; i < 6; i++) {
-			x = json_object_new_double(matrix[i]);
-			json_object_array_add(array, x);
+			json_writer_double(writer, matrix[i]);
 		}
-		json_object_object_add(object, "calibration_matrix", array);
+		json_writer_array_end(writer);
 	}
 
-	return object;
+	json_writer_object_end(writer);
 }
 
-json_object *ipc_json_describe_input(struct sway_input_device *device) {
+void ipc_json_write_input(struct json_writer *writer,
+		struct sway_input_device *device) {
 	if (!(sway_assert(device, "Device must not be null"))) {
-		return NULL;
+		json_writer_null(writer);
+		return;
 	}
 
-	json_object *object = json_object_new_object();
+	json_writer_object_begin(writer);
 
-	json_object_object_add(object, "identifier",
-		json_object_new_string(device->identifier));
-	json_object_object_add(object, "name",
-		json_object_new_string(device->wlr_device->name));
-	json_object_object_add(object, "vendor",
-		json_object_new_int(device->wlr_device->vendor));
-	json_object_object_add(object, "product",
-		json_object_new_int(device->wlr_device->product));
-	json_object_object_add(object, "type",
-		json_object_new_string(
-			input_device_get_type(device)));
+	json_writer_add_string(writer, "identifier", device->identifier);
+	json_writer_add_string(writer, "name", device->wlr_device->name);
+	json_writer_add_int(writer, "vendor", device->wlr_device->vendor);
+	json_writer_add_int(writer, "product", device->wlr_device->product);
+	json_writer_add_string(writer, "type", input_device_get_type(device));
 
 	if (device->wlr_device->type == WLR_INPUT_DEVICE_KEYBOARD) {
 		struct wlr_keyboard *keyboard = device->wlr_device->keyboard;
 		struct xkb_keymap *keymap = keyboard->keymap;
 		struct xkb_state *state = keyboard->xkb_state;
 
-		json_object *layouts_arr = json_object_new_array();
-		json_object_object_add(object, "xkb_layout_names", layouts_arr);
+		json_writer_key(writer, "xkb_layout_names");
+		json_writer_array_begin(writer);
 
+		// The last active layout is the one reported
+		bool has_active = false;
+		xkb_layout_index_t active_idx = 0;
 		xkb_layout_index_t num_layouts = xkb_keymap_num_layouts(keymap);
 		xkb_layout_index_t layout_idx;
 		for (layout_idx = 0; layout_idx < num_layouts; layout_idx++) {
 			const char *layout = xkb_keymap_layout_get_name(keymap, layout_idx);
-			json_object_array_add(layouts_arr,
-				layout ? json_object_new_string(layout) : NULL);
+			json_writer_string(writer, layout);
 
 			bool is_active = xkb_state_layout_index_is_active(state,
 				layout_idx, XKB_STATE_LAYOUT_EFFECTIVE);
 			if (is_active) {
-				json_object_object_add(object, "xkb_active_layout_index",
-					json_object_new_int(layout_idx));
-				json_object_object_add(object, "xkb_active_layout_name",
-					layout ? json_object_new_string(layout) : NULL);
+				has_active = true;
+				active_idx = layout_idx;
 			}
 		}
+		json_writer_array_end(writer);
+
+		if (has_active) {
+			json_writer_add_int(writer, "xkb_active_layout_index", active_idx);
+			json_writer_add_string(writer, "xkb_active_layout_name",
+				xkb_keymap_layout_get_name(keymap, active_idx));
+		}
 	}
 
 	if (device->wlr_device->type == WLR_INPUT_DEVICE_POINTER) {
@@ -1014,42 +1051,154 @@ json_object *ipc_json_describe_input(struct sway_input_device *device) {
 				ic->scroll_factor != FLT_MIN) {
 			scroll_factor = ic->scroll_factor;
 		}
-		json_object_object_add(object, "scroll_factor", 
-				json_object_new_double(scroll_factor));
+		json_writer_add_double(writer, "scroll_factor", scroll_factor);
 	}
 
 	if (wlr_input_device_is_libinput(device->wlr_device)) {
 		struct libinput_device *libinput_dev;
 		libinput_dev = wlr_libinput_get_device_handle(device->wlr_device);
-		json_object_object_add(object, "libinput",
-				describe_libinput_device(libinput_dev));
+		json_writer_key(writer, "libinput");
+		write_libinput_device(writer, libinput_dev);
 	}
 
-	return object;
+	json_writer_object_end(writer);
 }
 
-json_object *ipc_json_describe_seat(struct sway_seat *seat) {
+void ipc_json_write_seat(struct json_writer *writer, struct sway_seat *seat) {
 	if (!(sway_assert(seat, "Seat must not be null"))) {
-		return NULL;
+		json_writer_null(writer);
+		return;
 	}
 
-	json_object *object = json_object_new_object();
 	struct sway_node *focus = seat_get_focus(seat);
 
-	json_object_object_add(object, "name",
-		json_object_new_string(seat->wlr_seat->name));
-	json_object_object_add(object, "capabilities",
-		json_object_new_int(seat->wlr_seat->capabilities));
-	json_object_object_add(object, "focus",
-		json_object_new_int(focus ? focus->id : 0));
+	json_writer_object_begin(writer);
+
+	json_writer_add_string(writer, "name", seat->wlr_seat->name);
+	json_writer_add_int(writer, "capabilities", seat->wlr_seat->capabilities);
+	json_writer_add_int(writer, "focus", focus ? (int)focus->id : 0);
 
-	json_object *devices = json_object_new_array();
+	json_writer_key(writer, "devices");
+	json_writer_array_begin(writer);
 	struct sway_seat_device *device = NULL;
 	wl_list_for_each(device, &seat->devices, link) {
-		json_object_array_add(devices, ipc_json_describe_input(device->input_device));
+		ipc_json_write_input(writer, device->input_device);
 	}
-	json_object_object_add(object, "devices", devices);
+	json_writer_array_end(writer);
+
+	json_writer_object_end(writer);
+}
 
+static json_object *describe_histogram(const struct sway_histogram *histogram) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "count",
+		json_object_new_int64(histogram->count));
+	json_object_object_add(object, "p50",
+		json_object_new_int64(histogram_get_percentile(histogram, 50)));
+	json_object_object_add(object, "p95",
+		json_object_new_int64(histogram_get_percentile(histogram, 95)));
+	json_object_object_add(object, "p99",
+		json_object_new_int64(histogram_get_percentile(histogram, 99)));
+	return object;
+}
+
+json_object *ipc_json_describe_output_stats(struct sway_output *output) {
+	if (!(sway_assert(output, "Output must not be null"))) {
+		return NULL;
+	}
+
+	struct sway_frame_stats *stats = &output->frame_stats;
+	json_object *object = json_object_new_object();
+
+	json_object_object_add(object, "name",
+		json_object_new_string(output->wlr_output->name));
+	json_object_object_add(object, "frames",
+		json_object_new_int64(stats->frames));
+	json_object_object_add(object, "missed_frames",
+		json_object_new_int64(stats->missed_frames));
+	json_object_object_add(object, "render_time",
+		describe_histogram(&stats->render_time));
+	json_object_object_add(object, "damage_to_commit",
+		describe_histogram(&stats->damage_to_commit));
+	json_object_object_add(object, "present_interval",
+		describe_histogram(&stats->present_interval));
+
+	return object;
+}
+
+json_object *ipc_json_describe_transaction_record(
+		const struct sway_transaction_record *record) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "id", json_object_new_int64(record->id));
+	json_object_object_add(object, "nodes",
+		json_object_new_int(record->nodes));
+	json_object_object_add(object, "configures",
+		json_object_new_int(record->configures));
+	json_object_object_add(object, "wait_time",
+		json_object_new_int64(record->wait_usec));
+	json_object_object_add(object, "apply_time",
+		json_object_new_int64(record->apply_usec));
+	json_object_object_add(object, "timeout",
+		json_object_new_int(record->timeout_ms));
+	json_object_object_add(object, "timed_out",
+		json_object_new_boolean(record->timed_out));
+	json_object_object_add(object, "timeouts",
+		json_object_new_int(record->timeouts));
+	return object;
+}
+
+json_object *ipc_json_describe_transaction_stats(
+		const struct sway_transaction_stats *stats) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "committed",
+		json_object_new_int64(stats->committed));
+	json_object_object_add(object, "applied",
+		json_object_new_int64(stats->applied));
+	json_object_object_add(object, "timed_out",
+		json_object_new_int64(stats->timed_out));
+	json_object_object_add(object, "wait_time",
+		describe_histogram(&stats->wait_time));
+	json_object_object_add(object, "apply_time",
+		describe_histogram(&stats->apply_time));
+
+	json_object *timeouts = json_object_new_object();
+	for (int i = 0; stats->app_timeouts && i < stats->app_timeouts->length;
+			++i) {
+		struct sway_transaction_app_timeouts *app =
+			stats->app_timeouts->items[i];
+		json_object_object_add(timeouts, app->app_id,
+			json_object_new_int64(app->count));
+	}
+	json_object_object_add(object, "timeouts", timeouts);
+
+	json_object *history = json_object_new_array();
+	size_t start = stats->history_len < TRANSACTION_HISTORY ?
+		0 : stats->history_next;
+	for (size_t i = 0; i < stats->history_len; ++i) {
+		const struct sway_transaction_record *record =
+			&stats->history[(start + i) % TRANSACTION_HISTORY];
+		json_object_array_add(history,
+			ipc_json_describe_transaction_record(record));
+	}
+	json_object_object_add(object, "history", history);
+
+	return object;
+}
+
+json_object *ipc_json_describe_pool_stats(const struct pool_stats *stats) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "name",
+		json_object_new_string(stats->name));
+	json_object_object_add(object, "allocations",
+		json_object_new_int64(stats->allocations));
+	json_object_object_add(object, "reuses",
+		json_object_new_int64(stats->reuses));
+	json_object_object_add(object, "in_use",
+		json_object_new_int64(stats->in_use));
+	json_object_object_add(object, "cached",
+		json_object_new_int64(stats->cached));
+	json_object_object_add(object, "bytes",
+		json_object_new_int64(stats->bytes));
 	return object;
 }
 
@@ -1,5 +1,5 @@
 // See https://i3wm.org/docs/ipc.html for protocol information
-#define _POSIX_C_SOURCE 200112L
+#define _POSIX_C_SOURCE 200809L
 #include <linux/input-event-codes.h>
 #include <assert.h>
 #include <errno.h>
@@ -8,13 +8,16 @@
 #include <json.h>
 #endif
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include "sway/commands.h"
@@ -24,6 +27,7 @@
 #include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/keyboard.h"
 #include "sway/input/seat.h"
@@ -32,27 +36,60 @@
 #include "sway/tree/workspace.h"
 #include "list.h"
 #include "log.h"
+#include "pool.h"
 #include "util.h"
 
 static int ipc_socket = -1;
 static struct wl_event_source *ipc_event_source =  NULL;
 static struct sockaddr_un *ipc_sockaddr = NULL;
 static list_t *ipc_client_list = NULL;
+static uint64_t ipc_client_serial = 0;
 static struct wl_listener ipc_display_destroy;
 
 static const char ipc_magic[] = {'i', '3', '-', 'i', 'p', 'c'};
 
 #define IPC_HEADER_SIZE (sizeof(ipc_magic) + 8)
 
+// Messages handed to a single writev call
+#define IPC_WRITE_IOV_MAX 64
+
+// Repetitions of a HIT_TEST lookup, which block the compositor while they run
+#define IPC_HIT_TEST_MAX_ITERATIONS 10000
+
+// Initial capacity of the write queue of a client, a power of two
+#define IPC_WRITE_QUEUE_MIN_CAPACITY 16
+
+/**
+ * A message with its header, which is never modified once created so it can
+ * be queued for several clients without being copied.
+ */
+struct ipc_message {
+	int refs;
+	enum ipc_command_type type;
+	// Events of the same type and key supersede each other, NULL if they don't
+	char *key;
+	size_t len; // Of data, the terminating NUL excluded
+	char data[]; // Header and payload
+};
+
 struct ipc_client {
 	struct wl_event_source *event_source;
 	struct wl_event_source *writable_event_source;
 	struct sway_server *server;
 	int fd;
 	enum ipc_command_type subscribed_events;
-	size_t write_buffer_len;
-	size_t write_buffer_size;
-	char *write_buffer;
+	bool coalesce_events; // Drop unsent events superseded by newer ones
+	uint64_t id;
+	// Messages waiting to be sent, in a ring whose capacity is a power of two
+	struct ipc_message **write_queue;
+	size_t write_queue_head; // Index of the oldest message
+	size_t write_queue_count;
+	size_t write_queue_capacity;
+	size_t write_offset; // Bytes of the oldest message already sent
+	size_t queued_bytes; // Bytes left to send
+	size_t peak_queued_bytes;
+	uint64_t sent_bytes;
+	uint64_t coalesced_events;
 	// The following are for storing data between event_loop calls
 	uint32_t pending_length;
 	enum ipc_command_type pending_type;
@@ -67,6 +104,68 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	enum ipc_command_type payload_type);
 bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_type,
 	const char *payload, uint32_t payload_length);
+static struct ipc_message *ipc_message_create(enum ipc_command_type type,
+	const char *payload, uint32_t payload_length);
+static void ipc_message_begin(struct json_writer *writer);
+static struct ipc_message *ipc_message_end(struct json_writer *writer,
+	enum ipc_command_type type);
+static void ipc_message_set_key(struct ipc_message *message, const char *key);
+static void ipc_message_unref(struct ipc_message *message);
+static bool ipc_send_message(struct ipc_client *client,
+	struct ipc_message *message);
+static bool ipc_reply_end(struct ipc_client *client,
+	struct json_writer *writer, enum ipc_command_type payload_type);
+
+static struct ipc_message *write_queue_get(struct ipc_client *client,
+		size_t i) {
+	size_t mask = client->write_queue_capacity - 1;
+	return client->write_queue[(client->write_queue_head + i) & mask];
+}
+
+static bool write_queue_push(struct ipc_client *client,
+		struct ipc_message *message) {
+	if (client->write_queue_count == client->write_queue_capacity) {
+		// Unwrap the messages at the start of the larger ring
+		size_t capacity = client->write_queue_capacity * 2;
+		struct ipc_message **queue =
+			malloc(capacity * sizeof(struct ipc_message *));
+		if (!queue) {
+			return false;
+		}
+		for (size_t i = 0; i < client->write_queue_count; ++i) {
+			queue[i] = write_queue_get(client, i);
+		}
+		free(client->write_queue);
+		client->write_queue = queue;
+		client->write_queue_head = 0;
+		client->write_queue_capacity = capacity;
+	}
+	size_t mask = client->write_queue_capacity - 1;
+	client->write_queue[(client->write_queue_head + client->write_queue_count)
+		& mask] = message;
+	client->write_queue_count++;
+	return true;
+}
+
+static struct ipc_message *write_queue_pop(struct ipc_client *client) {
+	struct ipc_message *message = write_queue_get(client, 0);
+	client->write_queue_head =
+		(client->write_queue_head + 1) & (client->write_queue_capacity - 1);
+	client->write_queue_count--;
+	return message;
+}
+
+static struct ipc_message *write_queue_remove(struct ipc_client *client,
+		size_t i) {
+	size_t mask = client->write_queue_capacity - 1;
+	struct ipc_message *message = write_queue_get(client, i);
+	for (; i + 1 < client->write_queue_count; ++i) {
+		client->write_queue[(client->write_queue_head + i) & mask] =
+			write_queue_get(client, i + 1);
+	}
+	client->write_queue_count--;
+	return message;
+}
 
 static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	if (ipc_event_source) {
@@ -189,14 +288,25 @@ int ipc_handle_connection(int fd, uint32_t mask, void *data) {
 			client_fd, WL_EVENT_READABLE, ipc_client_handle_readable, client);
 	client->writable_event_source = NULL;
 
-	client->write_buffer_size = 128;
-	client->write_buffer_len = 0;
-	client->write_buffer = malloc(client->write_buffer_size);
-	if (!client->write_buffer) {
-		sway_log(SWAY_ERROR, "Unable to allocate ipc client write buffer");
+	client->write_queue = calloc(IPC_WRITE_QUEUE_MIN_CAPACITY,
+		sizeof(struct ipc_message *));
+	if (!client->write_queue) {
+		sway_log(SWAY_ERROR, "Unable to allocate ipc client write queue");
+		wl_event_source_remove(client->event_source);
 		close(client_fd);
+		free(client);
 		return 0;
 	}
+	client->write_queue_head = 0;
+	client->write_queue_count = 0;
+	client->write_queue_capacity = IPC_WRITE_QUEUE_MIN_CAPACITY;
+	client->write_offset = 0;
+	client->queued_bytes = 0;
+	client->peak_queued_bytes = 0;
+	client->sent_bytes = 0;
+	client->coalesced_events = 0;
+	client->coalesce_events = false;
+	client->id = ++ipc_client_serial;
 
 	sway_log(SWAY_DEBUG, "New client: fd %d", client_fd);
 	list_add(ipc_client_list, client);
@@ -282,17 +392,19 @@ static bool ipc_has_event_listeners(enum ipc_command_type event) {
 	return false;
 }
 
-static void ipc_send_event(const char *json_string, enum ipc_command_type event) {
+/**
+ * Queue the same message for every subscriber, it is serialized only once.
+ */
+static void ipc_send_event_message(struct ipc_message *message) {
 	struct ipc_client *client;
 	for (int i = 0; i < ipc_client_list->length; i++) {
 		client = ipc_client_list->items[i];
-		if ((client->subscribed_events & event_mask(event)) == 0) {
+		if ((client->subscribed_events & event_mask(message->type)) == 0) {
 			continue;
 		}
-		if (!ipc_send_reply(client, event, json_string,
-				(uint32_t)strlen(json_string))) {
+		if (!ipc_send_message(client, message)) {
 			sway_log_errno(SWAY_INFO, "Unable to send reply to IPC client");
-			/* ipc_send_reply destroys client on error, which also
+			/* ipc_send_message destroys client on error, which also
 			 * removes it from the list, so we need to process
 			 * current index again */
 			i--;
@@ -300,49 +412,94 @@ static void ipc_send_event(const char *json_string, enum ipc_command_type event)
 	}
 }
 
+/**
+ * Send an event which replaces the unsent events of the same type and key, for
+ * clients which asked for it.
+ */
+static void ipc_send_superseding_event(const char *json_string,
+		enum ipc_command_type event, const char *key) {
+	struct ipc_message *message = ipc_message_create(event, json_string,
+		(uint32_t)strlen(json_string));
+	if (!message) {
+		return;
+	}
+	ipc_message_set_key(message, key);
+	ipc_send_event_message(message);
+	ipc_message_unref(message);
+}
+
+static void ipc_send_event(const char *json_string, enum ipc_command_type event) {
+	ipc_send_superseding_event(json_string, event, NULL);
+}
+
 void ipc_event_workspace(struct sway_workspace *old,
 		struct sway_workspace *new, const char *change) {
+	if (old) {
+		ipc_json_invalidate_node(&old->node);
+	}
+	if (new) {
+		ipc_json_invalidate_node(&new->node);
+	}
 	if (!ipc_has_event_listeners(IPC_EVENT_WORKSPACE)) {
 		return;
 	}
 #ifdef HAVE_JSON
 	sway_log(SWAY_DEBUG, "Sending workspace::%s event", change);
-	json_object *obj = json_object_new_object();
-	json_object_object_add(obj, "change", json_object_new_string(change));
+	struct json_writer writer;
+	ipc_message_begin(&writer);
+	json_writer_object_begin(&writer);
+	json_writer_add_string(&writer, "change", change);
+	json_writer_key(&writer, "old");
 	if (old) {
-		json_object_object_add(obj, "old",
-				ipc_json_describe_node_recursive(&old->node));
+		ipc_json_write_node_recursive(&writer, &old->node);
 	} else {
-		json_object_object_add(obj, "old", NULL);
+		json_writer_null(&writer);
 	}
 
+	json_writer_key(&writer, "current");
 	if (new) {
-		json_object_object_add(obj, "current",
-				ipc_json_describe_node_recursive(&new->node));
+		ipc_json_write_node_recursive(&writer, &new->node);
 	} else {
-		json_object_object_add(obj, "current", NULL);
+		json_writer_null(&writer);
 	}
+	json_writer_object_end(&writer);
 
-	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_WORKSPACE);
-	json_object_put(obj);
+	struct ipc_message *message = ipc_message_end(&writer, IPC_EVENT_WORKSPACE);
+	if (message) {
+		if (strcmp(change, "focus") == 0) {
+			ipc_message_set_key(message, change);
+		}
+		ipc_send_event_message(message);
+		ipc_message_unref(message);
+	}
 #endif
 }
 
 void ipc_event_window(struct sway_container *window, const char *change) {
+	ipc_json_invalidate_node(&window->node);
 	if (!ipc_has_event_listeners(IPC_EVENT_WINDOW)) {
 		return;
 	}
 #ifdef HAVE_JSON
 	sway_log(SWAY_DEBUG, "Sending window::%s event", change);
-	json_object *obj = json_object_new_object();
-	json_object_object_add(obj, "change", json_object_new_string(change));
-	json_object_object_add(obj, "container",
-			ipc_json_describe_node_recursive(&window->node));
-
-	const char *json_string = json_object_to_json_string(obj);
-	ipc_send_event(json_string, IPC_EVENT_WINDOW);
-	json_object_put(obj);
+	struct json_writer writer;
+	ipc_message_begin(&writer);
+	json_writer_object_begin(&writer);
+	json_writer_add_string(&writer, "change", change);
+	json_writer_key(&writer, "container");
+	ipc_json_write_node_recursive(&writer, &window->node);
+	json_writer_object_end(&writer);
+
+	struct ipc_message *message = ipc_message_end(&writer, IPC_EVENT_WINDOW);
+	if (message) {
+		if (strcmp(change, "title") == 0) {
+			char key[32];
+			snprintf(key, sizeof(key), "title %zu", window->node.id);
+			ipc_message_set_key(message, key);
+		}
+		ipc_send_event_message(message);
+		ipc_message_unref(message);
+	}
 #endif
 }
 
@@ -355,7 +512,8 @@ void ipc_event_barconfig_update(struct bar_config *bar) {
 	json_object *json = ipc_json_describe_bar_config(bar);
 
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BARCONFIG_UPDATE);
+	ipc_send_superseding_event(json_string, IPC_EVENT_BARCONFIG_UPDATE,
+		bar->id);
 	json_object_put(json);
 #endif
 }
@@ -373,7 +531,8 @@ void ipc_event_bar_state_update(struct bar_config *bar) {
 			json_object_new_boolean(bar->visible_by_modifier));
 
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_BAR_STATE_UPDATE);
+	ipc_send_superseding_event(json_string, IPC_EVENT_BAR_STATE_UPDATE,
+		bar->id);
 	json_object_put(json);
 #endif
 }
@@ -523,12 +682,30 @@ void ipc_event_input(const char *change, struct sway_input_device *device) {
 #ifdef HAVE_JSON
 	sway_log(SWAY_DEBUG, "Sending input event");
 
-	json_object *json = json_object_new_object();
-	json_object_object_add(json, "change", json_object_new_string(change));
-	json_object_object_add(json, "input", ipc_json_describe_input(device));
+	struct json_writer writer;
+	ipc_message_begin(&writer);
+	json_writer_object_begin(&writer);
+	json_writer_add_string(&writer, "change", change);
+	json_writer_key(&writer, "input");
+	ipc_json_write_input(&writer, device);
+	json_writer_object_end(&writer);
 
+	struct ipc_message *message = ipc_message_end(&writer, IPC_EVENT_INPUT);
+	if (message) {
+		ipc_send_event_message(message);
+		ipc_message_unref(message);
+	}
+#endif
+}
+
+void ipc_event_transaction(const struct sway_transaction_record *record) {
+	if (!ipc_has_event_listeners(IPC_EVENT_TRANSACTION)) {
+		return;
+	}
+#ifdef HAVE_JSON
+	json_object *json = ipc_json_describe_transaction_record(record);
 	const char *json_string = json_object_to_json_string(json);
-	ipc_send_event(json_string, IPC_EVENT_INPUT);
+	ipc_send_event(json_string, IPC_EVENT_TRANSACTION);
 	json_object_put(json);
 #endif
 }
@@ -548,13 +725,24 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	if (client->write_buffer_len <= 0) {
+	if (client->queued_bytes == 0) {
 		return 0;
 	}
 
 	sway_log(SWAY_DEBUG, "Client %d writable", client->fd);
 
-	ssize_t written = write(client->fd, client->write_buffer, client->write_buffer_len);
+	struct iovec iov[IPC_WRITE_IOV_MAX];
+	int iovcnt = 0;
+	for (size_t i = 0; i < client->write_queue_count &&
+			iovcnt < IPC_WRITE_IOV_MAX; ++i) {
+		struct ipc_message *message = write_queue_get(client, i);
+		size_t offset = i == 0 ? client->write_offset : 0;
+		iov[iovcnt].iov_base = message->data + offset;
+		iov[iovcnt].iov_len = message->len - offset;
+		iovcnt++;
+	}
+
+	ssize_t written = writev(client->fd, iov, iovcnt);
 
 	if (written == -1 && errno == EAGAIN) {
 		return 0;
@@ -564,10 +752,23 @@ int ipc_client_handle_writable(int client_fd, uint32_t mask, void *data) {
 		return 0;
 	}
 
-	memmove(client->write_buffer, client->write_buffer + written, client->write_buffer_len - written);
-	client->write_buffer_len -= written;
+	// Drop the messages which were sent completely
+	client->queued_bytes -= written;
+	client->sent_bytes += written;
+	size_t left = written;
+	while (left > 0) {
+		struct ipc_message *message = write_queue_get(client, 0);
+		size_t remaining = message->len - client->write_offset;
+		if (left < remaining) {
+			client->write_offset += left;
+			break;
+		}
+		left -= remaining;
+		client->write_offset = 0;
+		ipc_message_unref(write_queue_pop(client));
+	}
 
-	if (client->write_buffer_len == 0 && client->writable_event_source) {
+	if (client->queued_bytes == 0 && client->writable_event_source) {
 		wl_event_source_remove(client->writable_event_source);
 		client->writable_event_source = NULL;
 	}
@@ -592,7 +793,10 @@ void ipc_client_disconnect(struct ipc_client *client) {
 		i++;
 	}
 	list_del(ipc_client_list, i);
-	free(client->write_buffer);
+	while (client->write_queue_count) {
+		ipc_message_unref(write_queue_pop(client));
+	}
+	free(client->write_queue);
 	close(client->fd);
 	free(client);
 }
@@ -600,21 +804,20 @@ void ipc_client_disconnect(struct ipc_client *client) {
 static void ipc_get_workspaces_callback(struct sway_workspace *workspace,
 		void *data) {
 #ifdef HAVE_JSON
-	json_object *workspace_json = ipc_json_describe_node(&workspace->node);
+	struct json_writer *writer = data;
+	json_writer_object_begin(writer);
+	ipc_json_write_node_members(writer, &workspace->node, false, false);
 	// override the default focused indicator because
 	// it's set differently for the get_workspaces reply
 	struct sway_seat *seat = input_manager_get_default_seat();
 	struct sway_workspace *focused_ws = seat_get_focused_workspace(seat);
 	bool focused = workspace == focused_ws;
-	json_object_object_del(workspace_json, "focused");
-	json_object_object_add(workspace_json, "focused",
-			json_object_new_boolean(focused));
-	json_object_array_add((json_object *)data, workspace_json);
+	json_writer_add_bool(writer, "focused", focused);
 
 	focused_ws = output_get_active_workspace(workspace->output);
 	bool visible = workspace == focused_ws;
-	json_object_object_add(workspace_json, "visible",
-			json_object_new_boolean(visible));
+	json_writer_add_bool(writer, "visible", visible);
+	json_writer_object_end(writer);
 #endif
 }
 
@@ -693,10 +896,13 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	case IPC_GET_OUTPUTS:
 	{
 #ifdef HAVE_JSON
-		json_object *outputs = json_object_new_array();
+		struct json_writer writer;
+		ipc_message_begin(&writer);
+		json_writer_array_begin(&writer);
 		for (int i = 0; i < root->outputs->length; ++i) {
 			struct sway_output *output = root->outputs->items[i];
-			json_object *output_json = ipc_json_describe_node(&output->node);
+			json_writer_object_begin(&writer);
+			ipc_json_write_node_members(&writer, &output->node, false, false);
 
 			// override the default focused indicator because it's set
 			// differently for the get_outputs reply
@@ -704,25 +910,20 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 			struct sway_workspace *focused_ws =
 				seat_get_focused_workspace(seat);
 			bool focused = focused_ws && output == focused_ws->output;
-			json_object_object_del(output_json, "focused");
-			json_object_object_add(output_json, "focused",
-				json_object_new_boolean(focused));
+			json_writer_add_bool(&writer, "focused", focused);
 
 			const char *subpixel = sway_wl_output_subpixel_to_string(output->wlr_output->subpixel);
-			json_object_object_add(output_json, "subpixel_hinting", json_object_new_string(subpixel));
-			json_object_array_add(outputs, output_json);
+			json_writer_add_string(&writer, "subpixel_hinting", subpixel);
+			json_writer_object_end(&writer);
 		}
 		struct sway_output *output;
 		wl_list_for_each(output, &root->all_outputs, link) {
 			if (!output->enabled && output != root->noop_output) {
-				json_object_array_add(outputs,
-						ipc_json_describe_disabled_output(output));
+				ipc_json_write_disabled_output(&writer, output);
 			}
 		}
-		const char *json_string = json_object_to_json_string(outputs);
-		ipc_send_reply(client, payload_type, json_string,
-			(uint32_t)strlen(json_string));
-		json_object_put(outputs); // free
+		json_writer_array_end(&writer);
+		ipc_reply_end(client, &writer, payload_type);
 #endif
 		goto exit_cleanup;
 	}
@@ -730,12 +931,12 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	case IPC_GET_WORKSPACES:
 	{
 #ifdef HAVE_JSON
-		json_object *workspaces = json_object_new_array();
-		root_for_each_workspace(ipc_get_workspaces_callback, workspaces);
-		const char *json_string = json_object_to_json_string(workspaces);
-		ipc_send_reply(client, payload_type, json_string,
-			(uint32_t)strlen(json_string));
-		json_object_put(workspaces); // free
+		struct json_writer writer;
+		ipc_message_begin(&writer);
+		json_writer_array_begin(&writer);
+		root_for_each_workspace(ipc_get_workspaces_callback, &writer);
+		json_writer_array_end(&writer);
+		ipc_reply_end(client, &writer, payload_type);
 #endif
 		goto exit_cleanup;
 	}
@@ -775,6 +976,11 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 				is_tick = true;
 			} else if (strcmp(event_type, "input") == 0) {
 				client->subscribed_events |= event_mask(IPC_EVENT_INPUT);
+			} else if (strcmp(event_type, "transaction") == 0) {
+				client->subscribed_events |= event_mask(IPC_EVENT_TRANSACTION);
+			} else if (strcmp(event_type, "coalesce") == 0) {
+				// Not an event, but an option for the ones above
+				client->coalesce_events = true;
 			} else {
 				const char msg[] = "{\"success\": false}";
 				ipc_send_reply(client, payload_type, msg, strlen(msg));
@@ -799,15 +1005,15 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	case IPC_GET_INPUTS:
 	{
 #ifdef HAVE_JSON
-		json_object *inputs = json_object_new_array();
+		struct json_writer writer;
+		ipc_message_begin(&writer);
+		json_writer_array_begin(&writer);
 		struct sway_input_device *device = NULL;
 		wl_list_for_each(device, &server.input->devices, link) {
-			json_object_array_add(inputs, ipc_json_describe_input(device));
+			ipc_json_write_input(&writer, device);
 		}
-		const char *json_string = json_object_to_json_string(inputs);
-		ipc_send_reply(client, payload_type, json_string,
-			(uint32_t)strlen(json_string));
-		json_object_put(inputs); // free
+		json_writer_array_end(&writer);
+		ipc_reply_end(client, &writer, payload_type);
 #endif
 		goto exit_cleanup;
 	}
@@ -815,27 +1021,148 @@ void ipc_client_handle_command(struct ipc_client *client, uint32_t payload_lengt
 	case IPC_GET_SEATS:
 	{
 #ifdef HAVE_JSON
-		json_object *seats = json_object_new_array();
+		struct json_writer writer;
+		ipc_message_begin(&writer);
+		json_writer_array_begin(&writer);
 		struct sway_seat *seat = NULL;
 		wl_list_for_each(seat, &server.input->seats, link) {
-			json_object_array_add(seats, ipc_json_describe_seat(seat));
+			ipc_json_write_seat(&writer, seat);
 		}
-		const char *json_string = json_object_to_json_string(seats);
+		json_writer_array_end(&writer);
+		ipc_reply_end(client, &writer, payload_type);
+#endif
+		goto exit_cleanup;
+	}
+
+	case IPC_GET_STATS:
+	{
+#ifdef HAVE_JSON
+		json_object *outputs = json_object_new_array();
+		for (int i = 0; i < root->outputs->length; ++i) {
+			struct sway_output *output = root->outputs->items[i];
+			json_object_array_add(outputs,
+				ipc_json_describe_output_stats(output));
+		}
+		const char *json_string = json_object_to_json_string(outputs);
 		ipc_send_reply(client, payload_type, json_string,
 			(uint32_t)strlen(json_string));
-		json_object_put(seats); // free
+		json_object_put(outputs); // free
 #endif
 		goto exit_cleanup;
 	}
 
-	case IPC_GET_TREE:
+	case IPC_GET_TRANSACTIONS:
 	{
 #ifdef HAVE_JSON
-		json_object *tree = ipc_json_describe_node_recursive(&root->node);
-		const char *json_string = json_object_to_json_string(tree);
+		json_object *stats =
+			ipc_json_describe_transaction_stats(transaction_get_stats());
+		const char *json_string = json_object_to_json_string(stats);
 		ipc_send_reply(client, payload_type, json_string,
 			(uint32_t)strlen(json_string));
-		json_object_put(tree);
+		json_object_put(stats); // free
+#endif
+		goto exit_cleanup;
+	}
+
+	case IPC_HIT_TEST:
+	{
+#ifdef HAVE_JSON
+		double lx, ly;
+		int iterations = 1;
+		if (sscanf(buf, "%lf %lf %d", &lx, &ly, &iterations) < 2 ||
+				iterations < 1 || iterations > IPC_HIT_TEST_MAX_ITERATIONS) {
+			const char msg[] = "{\"success\": false}";
+			ipc_send_reply(client, payload_type, msg, strlen(msg));
+			goto exit_cleanup;
+		}
+
+		// Repeat the hit test so it can be timed without the IPC round trip
+		struct sway_seat *seat = input_manager_current_seat();
+		struct sway_node *node = NULL;
+		struct wlr_surface *surface = NULL;
+		double sx, sy;
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (int i = 0; i < iterations; ++i) {
+			surface = NULL;
+			node = node_at_coords(seat, lx, ly, &surface, &sx, &sy);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double nsec = (end.tv_sec - start.tv_sec) * 1e9 +
+			(end.tv_nsec - start.tv_nsec);
+
+		struct json_writer writer;
+		ipc_message_begin(&writer);
+		json_writer_object_begin(&writer);
+		json_writer_add_bool(&writer, "success", true);
+		json_writer_key(&writer, "node");
+		if (node) {
+			ipc_json_write_node(&writer, node);
+		} else {
+			json_writer_null(&writer);
+		}
+		json_writer_add_bool(&writer, "surface", surface != NULL);
+		json_writer_add_int(&writer, "iterations", iterations);
+		json_writer_add_double(&writer, "average_time", nsec / iterations);
+		json_writer_object_end(&writer);
+		ipc_reply_end(client, &writer, payload_type);
+#endif
+		goto exit_cleanup;
+	}
+
+	case IPC_GET_POOLS:
+	{
+#ifdef HAVE_JSON
+		json_object *pools = json_object_new_array();
+		list_t *all_stats = pool_stats_get_all();
+		for (int i = 0; all_stats && i < all_stats->length; ++i) {
+			json_object_array_add(pools,
+				ipc_json_describe_pool_stats(all_stats->items[i]));
+		}
+		const char *json_string = json_object_to_json_string(pools);
+		ipc_send_reply(client, payload_type, json_string,
+			(uint32_t)strlen(json_string));
+		json_object_put(pools); // free
+#endif
+		goto exit_cleanup;
+	}
+
+	case IPC_GET_CLIENTS:
+	{
+#ifdef HAVE_JSON
+		struct json_writer writer;
+		ipc_message_begin(&writer);
+		json_writer_array_begin(&writer);
+		for (int i = 0; i < ipc_client_list->length; ++i) {
+			struct ipc_client *c = ipc_client_list->items[i];
+			json_writer_object_begin(&writer);
+			json_writer_add_int(&writer, "id", c->id);
+			json_writer_add_int(&writer, "queued_messages",
+				c->write_queue_count);
+			json_writer_add_int(&writer, "queued_bytes", c->queued_bytes);
+			json_writer_add_int(&writer, "peak_queued_bytes",
+				c->peak_queued_bytes);
+			json_writer_add_int(&writer, "max_queued_bytes",
+				config->ipc_max_queued_bytes);
+			json_writer_add_int(&writer, "sent_bytes", c->sent_bytes);
+			json_writer_add_bool(&writer, "coalesce", c->coalesce_events);
+			json_writer_add_int(&writer, "coalesced_events",
+				c->coalesced_events);
+			json_writer_object_end(&writer);
+		}
+		json_writer_array_end(&writer);
+		ipc_reply_end(client, &writer, payload_type);
+#endif
+		goto exit_cleanup;
+	}
+
+	case IPC_GET_TREE:
+	{
+#ifdef HAVE_JSON
+		struct json_writer writer;
+		ipc_message_begin(&writer);
+		ipc_json_write_node_recursive(&writer, &root->node);
+		ipc_reply_end(client, &writer, payload_type);
 #endif
 		goto exit_cleanup;
 	}
@@ -964,40 +1291,116 @@ exit_cleanup:
 	return;
 }
 
-bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_type,
+static void ipc_message_set_header(struct ipc_message *message,
+		enum ipc_command_type type, uint32_t payload_length) {
+	message->refs = 1;
+	message->type = type;
+	message->key = NULL;
+	message->len = IPC_HEADER_SIZE + payload_length;
+	char *header = message->data;
+	memcpy(header, ipc_magic, sizeof(ipc_magic));
+	memcpy(header + sizeof(ipc_magic), &payload_length, sizeof(payload_length));
+	memcpy(header + sizeof(ipc_magic) + sizeof(payload_length), &type, sizeof(type));
+}
+
+static struct ipc_message *ipc_message_create(enum ipc_command_type type,
 		const char *payload, uint32_t payload_length) {
-	assert(payload);
+	struct ipc_message *message = malloc(offsetof(struct ipc_message, data) +
+		IPC_HEADER_SIZE + payload_length + 1);
+	if (!message) {
+		sway_log(SWAY_ERROR, "Unable to allocate ipc message");
+		return NULL;
+	}
+	ipc_message_set_header(message, type, payload_length);
+	memcpy(message->data + IPC_HEADER_SIZE, payload, payload_length);
+	message->data[message->len] = '\0';
+	return message;
+}
+
+/**
+ * Start a message whose payload is written in place, after room left for the
+ * message and its header.
+ */
+static void ipc_message_begin(struct json_writer *writer) {
+	json_writer_init(writer, NULL, 0, 0);
+	json_writer_reserve(writer,
+		offsetof(struct ipc_message, data) + IPC_HEADER_SIZE);
+}
 
-	char data[IPC_HEADER_SIZE];
+/**
+ * Turn the buffer of the writer into a message, NULL if writing failed.
+ */
+static struct ipc_message *ipc_message_end(struct json_writer *writer,
+		enum ipc_command_type type) {
+	if (writer->failed) {
+		sway_log(SWAY_ERROR, "Unable to write ipc message");
+		json_writer_finish(writer);
+		return NULL;
+	}
+	struct ipc_message *message = (struct ipc_message *)writer->data;
+	size_t prefix = offsetof(struct ipc_message, data) + IPC_HEADER_SIZE;
+	ipc_message_set_header(message, type, writer->len - prefix);
+	return message;
+}
 
-	memcpy(data, ipc_magic, sizeof(ipc_magic));
-	memcpy(data + sizeof(ipc_magic), &payload_length, sizeof(payload_length));
-	memcpy(data + sizeof(ipc_magic) + sizeof(payload_length), &payload_type, sizeof(payload_type));
+/**
+ * Must be set before the message is queued for any client.
+ */
+static void ipc_message_set_key(struct ipc_message *message, const char *key) {
+	free(message->key);
+	message->key = key ? strdup(key) : NULL;
+}
 
-	while (client->write_buffer_len + IPC_HEADER_SIZE + payload_length >=
-				 client->write_buffer_size) {
-		client->write_buffer_size *= 2;
+static void ipc_message_unref(struct ipc_message *message) {
+	if (message && --message->refs == 0) {
+		free(message->key);
+		free(message);
 	}
+}
+
+/**
+ * Drop the unsent event which the message supersedes, if any. The event being
+ * sent can't be dropped anymore. Only one event may be queued for each key, so
+ * the search stops at the first one.
+ */
+static void ipc_client_coalesce(struct ipc_client *client,
+		struct ipc_message *message) {
+	size_t first = client->write_offset > 0 ? 1 : 0;
+	for (size_t i = client->write_queue_count; i > first; --i) {
+		struct ipc_message *queued = write_queue_get(client, i - 1);
+		if (queued->type == message->type && queued->key &&
+				strcmp(queued->key, message->key) == 0) {
+			write_queue_remove(client, i - 1);
+			client->queued_bytes -= queued->len;
+			client->coalesced_events++;
+			ipc_message_unref(queued);
+			return;
+		}
+	}
+}
 
-	if (client->write_buffer_size > 4e6) { // 4 MB
-		sway_log(SWAY_ERROR, "Client write buffer too big (%zu), disconnecting client",
-				client->write_buffer_size);
+static bool ipc_send_message(struct ipc_client *client,
+		struct ipc_message *message) {
+	if (client->coalesce_events && message->key) {
+		ipc_client_coalesce(client, message);
+	}
+	if (client->queued_bytes + message->len > config->ipc_max_queued_bytes) {
+		sway_log(SWAY_ERROR, "Client write queue too big (%zu), disconnecting client",
+				client->queued_bytes + message->len);
 		ipc_client_disconnect(client);
 		return false;
 	}
-
-	char *new_buffer = realloc(client->write_buffer, client->write_buffer_size);
-	if (!new_buffer) {
-		sway_log(SWAY_ERROR, "Unable to reallocate ipc client write buffer");
+	if (!write_queue_push(client, message)) {
+		sway_log(SWAY_ERROR, "Unable to grow client write queue, disconnecting client");
 		ipc_client_disconnect(client);
 		return false;
 	}
-	client->write_buffer = new_buffer;
 
-	memcpy(client->write_buffer + client->write_buffer_len, data, IPC_HEADER_SIZE);
-	client->write_buffer_len += IPC_HEADER_SIZE;
-	memcpy(client->write_buffer + client->write_buffer_len, payload, payload_length);
-	client->write_buffer_len += payload_length;
+	message->refs++;
+	client->queued_bytes += message->len;
+	if (client->queued_bytes > client->peak_queued_bytes) {
+		client->peak_queued_bytes = client->queued_bytes;
+	}
 
 	if (!client->writable_event_source) {
 		client->writable_event_source = wl_event_loop_add_fd(
@@ -1006,6 +1409,33 @@ bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_typ
 	}
 
 	sway_log(SWAY_DEBUG, "Added IPC reply of type 0x%x to client %d queue: %s",
-		payload_type, client->fd, payload);
+		message->type, client->fd, message->data + IPC_HEADER_SIZE);
 	return true;
 }
+
+bool ipc_send_reply(struct ipc_client *client, enum ipc_command_type payload_type,
+		const char *payload, uint32_t payload_length) {
+	assert(payload);
+
+	struct ipc_message *message =
+		ipc_message_create(payload_type, payload, payload_length);
+	if (!message) {
+		ipc_client_disconnect(client);
+		return false;
+	}
+	bool sent = ipc_send_message(client, message);
+	ipc_message_unref(message);
+	return sent;
+}
+
+static bool ipc_reply_end(struct ipc_client *client,
+		struct json_writer *writer, enum ipc_command_type payload_type) {
+	struct ipc_message *message = ipc_message_end(writer, payload_type);
+	if (!message) {
+		ipc_client_disconnect(client);
+		return false;
+	}
+	bool sent = ipc_send_message(client, message);
+	ipc_message_unref(message);
+	return sent;
+}
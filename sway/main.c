@@ -15,6 +15,7 @@
 #include <unistd.h>
 #include <wlr/util/log.h>
 #include <wlr/version.h>
+#include "sway/benchmark.h"
 #include "sway/commands.h"
 #include "sway/config.h"
 #include "sway/server.h"
@@ -30,7 +31,9 @@
 static bool terminate_request = false;
 static int exit_value = 0;
 struct sway_server server = {0};
-struct sway_debug debug = {0};
+struct sway_debug debug = {
+	.damage_max_rects = 32,
+};
 
 void sway_terminate(int exit_code) {
 	if (!server.wl_display) {
@@ -182,6 +185,16 @@ void enable_debug_flag(const char *flag) {
 		debug.txn_wait = true;
 	} else if (strcmp(flag, "txn-timings") == 0) {
 		debug.txn_timings = true;
+	} else if (strcmp(flag, "noculling") == 0) {
+		debug.noculling = true;
+	} else if (strcmp(flag, "norectbatch") == 0) {
+		debug.norectbatch = true;
+	} else if (strcmp(flag, "render-stats") == 0) {
+		debug.render_stats = true;
+	} else if (strncmp(flag, "benchmark=", 10) == 0) {
+		debug.benchmark_frames = atoi(&flag[10]);
+	} else if (strncmp(flag, "damage-max-rects=", 17) == 0) {
+		debug.damage_max_rects = atoi(&flag[17]);
 	} else if (strncmp(flag, "txn-timeout=", 12) == 0) {
 		server.txn_timeout_ms = atoi(&flag[12]);
 	} else {
@@ -394,6 +407,10 @@ int main(int argc, char **argv) {
 		swaynag_show(&config->swaynag_config_errors);
 	}
 
+	if (debug.benchmark_frames > 0) {
+		benchmark_start(debug.benchmark_frames);
+	}
+
 	server_run(&server);
 
 shutdown:
@@ -39,6 +39,7 @@
 #include "sway/input/input-manager.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/text_texture.h"
 #include "sway/tree/root.h"
 #if HAVE_XWAYLAND
 #include "sway/xwayland.h"
@@ -202,6 +203,12 @@ bool sway_server_init(struct sway_server *server) {
 	}
 
 	server->dirty_nodes = create_list();
+	server->queued_transactions = create_list();
+	server->pending_transactions = create_list();
+	server->dirty_titles = create_list();
+
+	server->text_texture_ready.notify = handle_text_texture_ready;
+	text_texture_cache_init(server->wl_event_loop, &server->text_texture_ready);
 
 	server->input = input_manager_create(server);
 	input_manager_get_default_seat(); // create seat0
@@ -215,8 +222,12 @@ void server_fini(struct sway_server *server) {
 	wlr_xwayland_destroy(server->xwayland.wlr_xwayland);
 #endif
 	wl_display_destroy_clients(server->wl_display);
+	text_texture_cache_finish();
 	wl_display_destroy(server->wl_display);
 	list_free(server->dirty_nodes);
+	list_free(server->queued_transactions);
+	list_free(server->pending_transactions);
+	list_free(server->dirty_titles);
 }
 
 bool server_start(struct sway_server *server) {
@@ -0,0 +1,568 @@
+#define _POSIX_C_SOURCE 200809L
+#include <drm_fourcc.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/render/wlr_texture.h>
+#include "cairo_util.h"
+#include "list.h"
+#include "log.h"
+#include "pango.h"
+#include "sway/text_texture.h"
+#include "util.h"
+
+// How many unreferenced textures are kept around for reuse
+#define UNUSED_MAX 256
+
+// Upper bound for the number of rasterization threads
+#define WORKERS_MAX 4
+
+struct text_job;
+
+struct sway_text_texture {
+	struct sway_text_texture_key key; // Owns the strings
+	uint32_t hash;
+	struct wlr_texture *texture;
+	int refs;
+
+	// While the text is being rasterized by a worker, the fallback is
+	// rendered in its place
+	struct text_job *job;
+	struct sway_text_texture *fallback;
+	list_t *users; // Notified once the job is done, NULL if there are none
+
+	struct wl_list bucket_link; // cache.buckets
+	struct wl_list unused_link; // cache.unused, only when refs == 0
+};
+
+/**
+ * Text handed to a worker thread. The worker only reads the key and writes
+ * the pixels; everything else belongs to the main thread.
+ */
+struct text_job {
+	struct sway_text_texture_key key; // Owns the strings
+	struct sway_text_texture *text; // NULL if the texture was destroyed
+
+	unsigned char *data; // ARGB8888, NULL if the text renders to nothing
+	int width, height, stride;
+
+	struct wl_list link; // pool.queue or pool.done
+};
+
+static struct {
+	struct wl_list *buckets;
+	size_t nbuckets;
+	size_t length;
+
+	struct wl_list unused; // sway_text_texture::unused_link, most recent first
+	size_t nunused;
+
+	size_t hits, misses;
+} cache;
+
+static struct {
+	pthread_t threads[WORKERS_MAX];
+	int nthreads;
+	bool stopping;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct wl_list queue; // text_job::link, oldest last
+	struct wl_list done; // text_job::link, oldest last
+
+	// A byte is written to the pipe whenever done becomes non-empty
+	int notify_fd[2];
+	struct wl_event_source *notify_source;
+	struct wl_signal ready;
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.notify_fd = { -1, -1 },
+};
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t size) {
+	// FNV-1a
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t hash_key(const struct sway_text_texture_key *key) {
+	uint32_t hash = 2166136261u;
+	hash = hash_bytes(hash, key->text, strlen(key->text) + 1);
+	hash = hash_bytes(hash, key->font, strlen(key->font) + 1);
+	hash = hash_bytes(hash, &key->markup, sizeof(key->markup));
+	hash = hash_bytes(hash, &key->scale, sizeof(key->scale));
+	hash = hash_bytes(hash, &key->height, sizeof(key->height));
+	hash = hash_bytes(hash, &key->subpixel, sizeof(key->subpixel));
+	hash = hash_bytes(hash, key->foreground, sizeof(key->foreground));
+	hash = hash_bytes(hash, key->background, sizeof(key->background));
+	hash = hash_bytes(hash, &key->renderer, sizeof(key->renderer));
+	return hash;
+}
+
+static bool key_equal(const struct sway_text_texture_key *a,
+		const struct sway_text_texture_key *b) {
+	return a->markup == b->markup && a->scale == b->scale &&
+		a->height == b->height && a->subpixel == b->subpixel &&
+		a->renderer == b->renderer &&
+		memcmp(a->foreground, b->foreground, sizeof(a->foreground)) == 0 &&
+		memcmp(a->background, b->background, sizeof(a->background)) == 0 &&
+		strcmp(a->text, b->text) == 0 && strcmp(a->font, b->font) == 0;
+}
+
+static bool cache_resize(size_t nbuckets) {
+	struct wl_list *buckets = calloc(nbuckets, sizeof(struct wl_list));
+	if (!sway_assert(buckets, "Unable to allocate text texture cache")) {
+		return false;
+	}
+	for (size_t i = 0; i < nbuckets; ++i) {
+		wl_list_init(&buckets[i]);
+	}
+	for (size_t i = 0; i < cache.nbuckets; ++i) {
+		struct sway_text_texture *text, *tmp;
+		wl_list_for_each_safe(text, tmp, &cache.buckets[i], bucket_link) {
+			wl_list_remove(&text->bucket_link);
+			wl_list_insert(&buckets[text->hash & (nbuckets - 1)],
+				&text->bucket_link);
+		}
+	}
+	free(cache.buckets);
+	cache.buckets = buckets;
+	cache.nbuckets = nbuckets;
+	return true;
+}
+
+static void rasterize_text(struct text_job *job) {
+#ifdef HAVE_FONTS
+	const struct sway_text_texture_key *key = &job->key;
+	int width = 0;
+	int height = key->height;
+
+	// We must use a non-nil cairo_t for cairo_set_font_options to work.
+	// Therefore, we cannot use cairo_create(NULL).
+	cairo_surface_t *dummy_surface = cairo_image_surface_create(
+			CAIRO_FORMAT_ARGB32, 0, 0);
+	cairo_t *c = cairo_create(dummy_surface);
+	cairo_set_antialias(c, CAIRO_ANTIALIAS_BEST);
+	cairo_font_options_t *fo = cairo_font_options_create();
+	cairo_font_options_set_hint_style(fo, CAIRO_HINT_STYLE_FULL);
+	if (key->subpixel == WL_OUTPUT_SUBPIXEL_NONE) {
+		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_GRAY);
+	} else {
+		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_SUBPIXEL);
+		cairo_font_options_set_subpixel_order(fo,
+			to_cairo_subpixel_order(key->subpixel));
+	}
+	cairo_set_font_options(c, fo);
+	get_text_size(c, key->font, &width, NULL, NULL, key->scale,
+			key->markup, "%s", key->text);
+	cairo_surface_destroy(dummy_surface);
+	cairo_destroy(c);
+
+	if (width == 0 || height == 0) {
+		cairo_font_options_destroy(fo);
+		return;
+	}
+
+	int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+	unsigned char *data = malloc((size_t)stride * height);
+	if (!data) {
+		sway_log(SWAY_ERROR, "Unable to allocate text buffer");
+		cairo_font_options_destroy(fo);
+		return;
+	}
+
+	cairo_surface_t *surface = cairo_image_surface_create_for_data(data,
+			CAIRO_FORMAT_ARGB32, width, height, stride);
+	cairo_t *cairo = cairo_create(surface);
+	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
+	cairo_set_font_options(cairo, fo);
+	cairo_font_options_destroy(fo);
+	cairo_set_source_rgba(cairo, key->background[0], key->background[1],
+			key->background[2], key->background[3]);
+	cairo_paint(cairo);
+	PangoContext *pango = pango_cairo_create_context(cairo);
+	cairo_set_source_rgba(cairo, key->foreground[0], key->foreground[1],
+			key->foreground[2], key->foreground[3]);
+	cairo_move_to(cairo, 0, 0);
+
+	pango_printf(cairo, key->font, key->scale, key->markup,
+			"%s", key->text);
+
+	cairo_surface_flush(surface);
+	cairo_surface_destroy(surface);
+	g_object_unref(pango);
+	cairo_destroy(cairo);
+
+	job->data = data;
+	job->width = width;
+	job->height = height;
+	job->stride = stride;
+#endif
+}
+
+static struct text_job *job_create(const struct sway_text_texture_key *key) {
+	struct text_job *job = calloc(1, sizeof(struct text_job));
+	if (!sway_assert(job, "Unable to allocate text job")) {
+		return NULL;
+	}
+	job->key = *key;
+	job->key.text = strdup(key->text);
+	job->key.font = strdup(key->font);
+	return job;
+}
+
+static void job_destroy(struct text_job *job) {
+	free(job->data);
+	free((char *)job->key.text);
+	free((char *)job->key.font);
+	free(job);
+}
+
+/**
+ * Upload the pixels of a finished job. This must happen on the main thread,
+ * which owns the renderer.
+ */
+static struct wlr_texture *job_upload(struct text_job *job) {
+	if (!job->data) {
+		return NULL;
+	}
+	return wlr_texture_from_pixels(job->key.renderer, DRM_FORMAT_ARGB8888,
+			job->stride, job->width, job->height, job->data);
+}
+
+static void *worker_run(void *data) {
+	// Signals are handled by the main loop
+	sigset_t mask;
+	sigfillset(&mask);
+	pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+	pthread_mutex_lock(&pool.lock);
+	while (true) {
+		while (!pool.stopping && wl_list_empty(&pool.queue)) {
+			pthread_cond_wait(&pool.cond, &pool.lock);
+		}
+		if (pool.stopping) {
+			break;
+		}
+		struct text_job *job = wl_container_of(pool.queue.prev, job, link);
+		wl_list_remove(&job->link);
+		pthread_mutex_unlock(&pool.lock);
+
+		rasterize_text(job);
+
+		pthread_mutex_lock(&pool.lock);
+		if (wl_list_empty(&pool.done)) {
+			if (write(pool.notify_fd[1], "", 1) < 0) {
+				sway_log_errno(SWAY_ERROR, "Unable to notify text job");
+			}
+		}
+		wl_list_insert(&pool.done, &job->link);
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return NULL;
+}
+
+static void text_texture_ref(struct sway_text_texture *text) {
+	if (text->refs++ == 0) {
+		wl_list_remove(&text->unused_link);
+		cache.nunused--;
+	}
+}
+
+static void job_finish(struct text_job *job) {
+	struct sway_text_texture *text = job->text;
+	if (text) {
+		text->texture = job_upload(job);
+		text->job = NULL;
+		struct sway_text_texture *fallback = text->fallback;
+		text->fallback = NULL;
+		list_t *users = text->users;
+		text->users = NULL;
+		for (int i = 0; users && i < users->length; ++i) {
+			wl_signal_emit(&pool.ready, users->items[i]);
+		}
+		list_free(users);
+		text_texture_unref(fallback);
+	}
+	job_destroy(job);
+}
+
+static int handle_jobs_done(int fd, uint32_t mask, void *data) {
+	// Drain the pipe before taking the jobs, so a job finishing in between
+	// notifies us again
+	char buf[64];
+	while (read(fd, buf, sizeof(buf)) > 0) {
+		// Nothing
+	}
+
+	struct wl_list done;
+	wl_list_init(&done);
+	pthread_mutex_lock(&pool.lock);
+	wl_list_insert_list(&done, &pool.done);
+	wl_list_init(&pool.done);
+	pthread_mutex_unlock(&pool.lock);
+
+	struct text_job *job, *tmp;
+	wl_list_for_each_reverse_safe(job, tmp, &done, link) {
+		wl_list_remove(&job->link);
+		job_finish(job);
+	}
+	return 0;
+}
+
+static void text_texture_destroy(struct sway_text_texture *text) {
+	wl_list_remove(&text->bucket_link);
+	cache.length--;
+	if (text->job) {
+		text->job->text = NULL;
+	}
+	text_texture_unref(text->fallback);
+	list_free(text->users);
+	wlr_texture_destroy(text->texture);
+	free((char *)text->key.text);
+	free((char *)text->key.font);
+	free(text);
+}
+
+struct sway_text_texture *text_texture_get(
+		const struct sway_text_texture_key *key,
+		struct sway_text_texture *fallback) {
+	if (!key->text || !key->font || !key->renderer) {
+		return NULL;
+	}
+	if (!cache.buckets) {
+		wl_list_init(&cache.unused);
+		if (!cache_resize(64)) {
+			return NULL;
+		}
+	}
+
+	uint32_t hash = hash_key(key);
+	struct wl_list *bucket = &cache.buckets[hash & (cache.nbuckets - 1)];
+	struct sway_text_texture *text;
+	wl_list_for_each(text, bucket, bucket_link) {
+		if (text->hash == hash && key_equal(&text->key, key)) {
+			cache.hits++;
+			text_texture_ref(text);
+			return text;
+		}
+	}
+
+	cache.misses++;
+	struct text_job *job = job_create(key);
+	if (!job) {
+		return NULL;
+	}
+
+	text = calloc(1, sizeof(struct sway_text_texture));
+	if (!sway_assert(text, "Unable to allocate text texture")) {
+		job_destroy(job);
+		return NULL;
+	}
+	text->key = *key;
+	text->key.text = strdup(key->text);
+	text->key.font = strdup(key->font);
+	text->hash = hash;
+	text->refs = 1;
+	wl_list_insert(bucket, &text->bucket_link);
+	cache.length++;
+
+	if (pool.nthreads == 0) {
+		rasterize_text(job);
+		text->texture = job_upload(job);
+		job_destroy(job);
+	} else {
+		job->text = text;
+		text->job = job;
+		if (fallback) {
+			text_texture_ref(fallback);
+			text->fallback = fallback;
+		}
+		pthread_mutex_lock(&pool.lock);
+		wl_list_insert(&pool.queue, &job->link);
+		pthread_cond_signal(&pool.cond);
+		pthread_mutex_unlock(&pool.lock);
+	}
+
+	if (cache.length > cache.nbuckets) {
+		cache_resize(cache.nbuckets * 2);
+	}
+	return text;
+}
+
+void text_texture_unref(struct sway_text_texture *text) {
+	if (!text) {
+		return;
+	}
+	if (!sway_assert(text->refs > 0, "Text texture is not referenced")) {
+		return;
+	}
+	if (--text->refs > 0) {
+		return;
+	}
+
+	wl_list_insert(&cache.unused, &text->unused_link);
+	cache.nunused++;
+
+	while (cache.nunused > UNUSED_MAX) {
+		struct sway_text_texture *oldest =
+			wl_container_of(cache.unused.prev, oldest, unused_link);
+		wl_list_remove(&oldest->unused_link);
+		cache.nunused--;
+		text_texture_destroy(oldest);
+	}
+}
+
+void text_texture_add_user(struct sway_text_texture *text, void *user) {
+	if (!text || !text->job) {
+		return;
+	}
+	if (!text->users) {
+		text->users = create_list();
+	}
+	if (text->users) {
+		list_add(text->users, user);
+	}
+}
+
+void text_texture_remove_user(struct sway_text_texture *text, void *user) {
+	if (!text || !text->users) {
+		return;
+	}
+	int index = list_find(text->users, user);
+	if (index != -1) {
+		list_del(text->users, index);
+	}
+}
+
+struct wlr_texture *text_texture_get_texture(struct sway_text_texture *text) {
+	while (text && text->job) {
+		text = text->fallback;
+	}
+	return text ? text->texture : NULL;
+}
+
+void text_texture_cache_get_stats(struct sway_text_texture_stats *stats) {
+	stats->hits = cache.hits;
+	stats->misses = cache.misses;
+	stats->entries = cache.length;
+	stats->unused = cache.nunused;
+}
+
+void text_texture_cache_clear(void) {
+	if (!cache.buckets) {
+		return;
+	}
+	// Destroying a texture may release its fallback onto the unused list
+	while (!wl_list_empty(&cache.unused)) {
+		struct sway_text_texture *text =
+			wl_container_of(cache.unused.next, text, unused_link);
+		wl_list_remove(&text->unused_link);
+		cache.nunused--;
+		text_texture_destroy(text);
+	}
+}
+
+static bool pool_init_pipe(void) {
+	if (pipe(pool.notify_fd) != 0) {
+		sway_log_errno(SWAY_ERROR, "Unable to create text job pipe");
+		return false;
+	}
+	for (int i = 0; i < 2; ++i) {
+		if (!sway_set_cloexec(pool.notify_fd[i], true) ||
+				fcntl(pool.notify_fd[i], F_SETFL, O_NONBLOCK) == -1) {
+			sway_log_errno(SWAY_ERROR, "Unable to set up text job pipe");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool text_texture_cache_init(struct wl_event_loop *loop,
+		struct wl_listener *ready) {
+	wl_list_init(&pool.queue);
+	wl_list_init(&pool.done);
+	wl_signal_init(&pool.ready);
+	wl_signal_add(&pool.ready, ready);
+
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int nthreads = ncpus > 2 ? ncpus - 1 : 1;
+	if (nthreads > WORKERS_MAX) {
+		nthreads = WORKERS_MAX;
+	}
+
+	if (!pool_init_pipe()) {
+		goto error;
+	}
+	pool.notify_source = wl_event_loop_add_fd(loop, pool.notify_fd[0],
+			WL_EVENT_READABLE, handle_jobs_done, NULL);
+	if (!pool.notify_source) {
+		sway_log(SWAY_ERROR, "Unable to watch text job pipe");
+		goto error;
+	}
+
+	for (int i = 0; i < nthreads; ++i) {
+		if (pthread_create(&pool.threads[i], NULL, worker_run, NULL) != 0) {
+			sway_log(SWAY_ERROR, "Unable to create text rasterization thread");
+			break;
+		}
+		pool.nthreads++;
+	}
+	if (pool.nthreads == 0) {
+		goto error;
+	}
+	sway_log(SWAY_DEBUG, "Rasterizing text on %d threads", pool.nthreads);
+	return true;
+
+error:
+	sway_log(SWAY_ERROR, "Text will be rasterized on the main thread");
+	if (pool.notify_source) {
+		wl_event_source_remove(pool.notify_source);
+		pool.notify_source = NULL;
+	}
+	for (int i = 0; i < 2; ++i) {
+		if (pool.notify_fd[i] != -1) {
+			close(pool.notify_fd[i]);
+			pool.notify_fd[i] = -1;
+		}
+	}
+	return false;
+}
+
+void text_texture_cache_finish(void) {
+	if (pool.nthreads > 0) {
+		pthread_mutex_lock(&pool.lock);
+		pool.stopping = true;
+		pthread_cond_broadcast(&pool.cond);
+		pthread_mutex_unlock(&pool.lock);
+		for (int i = 0; i < pool.nthreads; ++i) {
+			pthread_join(pool.threads[i], NULL);
+		}
+		pool.nthreads = 0;
+
+		// Nothing is waiting for these anymore
+		struct text_job *job, *tmp;
+		wl_list_insert_list(&pool.queue, &pool.done);
+		wl_list_for_each_safe(job, tmp, &pool.queue, link) {
+			wl_list_remove(&job->link);
+			if (job->text) {
+				job->text->job = NULL;
+			}
+			job_destroy(job);
+		}
+		wl_event_source_remove(pool.notify_source);
+		close(pool.notify_fd[0]);
+		close(pool.notify_fd[1]);
+	}
+	text_texture_cache_clear();
+}
@@ -13,6 +13,58 @@
 #include "list.h"
 #include "log.h"
 
+static bool list_equal(list_t *a, list_t *b) {
+	if (!a || !b) {
+		return a == b;
+	}
+	if (a->length != b->length) {
+		return false;
+	}
+	return memcmp(a->items, b->items, a->length * sizeof(void *)) == 0;
+}
+
+/**
+ * Mark a container dirty if arranging changed its state since it was last
+ * added to a transaction. Containers which come out the same don't need to
+ * be configured, have their buffers saved or be damaged again.
+ */
+static void container_set_dirty_if_changed(struct sway_container *con) {
+	struct sway_container_state *state = &con->pending;
+	struct sway_container_state *sent = &con->transacted;
+	if (state->layout != sent->layout ||
+			state->x != sent->x || state->y != sent->y ||
+			state->width != sent->width || state->height != sent->height ||
+			state->fullscreen_mode != sent->fullscreen_mode ||
+			state->workspace != sent->workspace ||
+			state->parent != sent->parent ||
+			state->border != sent->border ||
+			state->border_thickness != sent->border_thickness ||
+			state->border_top != sent->border_top ||
+			state->border_bottom != sent->border_bottom ||
+			state->border_left != sent->border_left ||
+			state->border_right != sent->border_right ||
+			state->content_x != sent->content_x ||
+			state->content_y != sent->content_y ||
+			state->content_width != sent->content_width ||
+			state->content_height != sent->content_height ||
+			!list_equal(state->children, sent->children)) {
+		node_set_dirty(&con->node);
+	}
+}
+
+static void workspace_set_dirty_if_changed(struct sway_workspace *ws) {
+	struct sway_workspace_state *sent = &ws->transacted;
+	if (ws->x != sent->x || ws->y != sent->y ||
+			ws->width != sent->width || ws->height != sent->height ||
+			ws->layout != sent->layout ||
+			ws->fullscreen != sent->fullscreen ||
+			ws->output != sent->output ||
+			!list_equal(ws->floating, sent->floating) ||
+			!list_equal(ws->tiling, sent->tiling)) {
+		node_set_dirty(&ws->node);
+	}
+}
+
 static void apply_horiz_layout(list_t *children, struct wlr_box *parent) {
 	if (!children->length) {
 		return;
@@ -207,8 +259,22 @@ static void arrange_floating(list_t *floating) {
 	}
 }
 
+/**
+ * Whether a child's arrangement depends only on its own box and node. Smart
+ * borders depend on the rest of the workspace, so they turn skipping off.
+ */
+static bool container_can_skip_arrange(struct sway_container *con) {
+	return !con->node.layout_dirty &&
+		config->hide_edge_borders_smart == ESMART_OFF &&
+		con->pending.x == con->arranged_x &&
+		con->pending.y == con->arranged_y &&
+		con->pending.width == con->arranged_width &&
+		con->pending.height == con->arranged_height;
+}
+
 static void arrange_children(list_t *children,
-		enum sway_container_layout layout, struct wlr_box *parent) {
+		enum sway_container_layout layout, struct wlr_box *parent,
+		bool force) {
 	// Calculate x, y, width and height of children
 	switch (layout) {
 	case L_HORIZ:
@@ -228,9 +294,12 @@ static void arrange_children(list_t *children,
 		break;
 	}
 
-	// Recurse into child containers
+	// Recurse into the child containers whose arrangement may have changed
 	for (int i = 0; i < children->length; ++i) {
 		struct sway_container *child = children->items[i];
+		if (!force && container_can_skip_arrange(child)) {
+			continue;
+		}
 		arrange_container(child);
 	}
 }
@@ -239,15 +308,22 @@ void arrange_container(struct sway_container *container) {
 	if (config->reloading) {
 		return;
 	}
+	bool force = container->node.layout_dirty;
+	container->node.layout_dirty = false;
+	container->arranged_x = container->pending.x;
+	container->arranged_y = container->pending.y;
+	container->arranged_width = container->pending.width;
+	container->arranged_height = container->pending.height;
 	if (container->view) {
 		view_autoconfigure(container->view);
-		node_set_dirty(&container->node);
+		container_set_dirty_if_changed(container);
 		return;
 	}
 	struct wlr_box box;
 	container_get_box(container, &box);
-	arrange_children(container->pending.children, container->pending.layout, &box);
-	node_set_dirty(&container->node);
+	arrange_children(container->pending.children, container->pending.layout,
+		&box, force);
+	container_set_dirty_if_changed(container);
 }
 
 void arrange_workspace(struct sway_workspace *workspace) {
@@ -289,7 +365,7 @@ void arrange_workspace(struct sway_workspace *workspace) {
 	}
 
 	workspace_add_gaps(workspace);
-	node_set_dirty(&workspace->node);
+	workspace_set_dirty_if_changed(workspace);
 	sway_log(SWAY_DEBUG, "Arranging workspace '%s' at %f, %f", workspace->name,
 			workspace->x, workspace->y);
 	if (workspace->fullscreen) {
@@ -302,7 +378,9 @@ void arrange_workspace(struct sway_workspace *workspace) {
 	} else {
 		struct wlr_box box;
 		workspace_get_box(workspace, &box);
-		arrange_children(workspace->tiling, workspace->layout, &box);
+		arrange_children(workspace->tiling, workspace->layout, &box,
+			workspace->node.layout_dirty);
+		workspace->node.layout_dirty = false;
 		arrange_floating(workspace->floating);
 	}
 }
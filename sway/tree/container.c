@@ -1,6 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
 #include <assert.h>
-#include <drm_fourcc.h>
 #include <limits.h>
 #include <float.h>
 #include <stdint.h>
@@ -9,25 +8,33 @@
 #include <strings.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_output_layout.h>
-#include "cairo_util.h"
 #include "pango.h"
 #include "sway/config.h"
 #include "sway/desktop.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
+#include "sway/ipc-json.h"
 #include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/server.h"
+#include "sway/text_texture.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
 #include "list.h"
 #include "log.h"
+#include "pool.h"
 #include "stringop.h"
 
+static pool_t *container_pool = NULL;
+
 struct sway_container *container_create(struct sway_view *view) {
-	struct sway_container *c = calloc(1, sizeof(struct sway_container));
+	if (!container_pool) {
+		container_pool = create_pool("container", sizeof(struct sway_container));
+	}
+	struct sway_container *c =
+		container_pool ? pool_alloc(container_pool) : NULL;
 	if (!c) {
 		sway_log(SWAY_ERROR, "Unable to allocate sway_container");
 		return NULL;
@@ -43,6 +50,7 @@ struct sway_container *container_create(struct sway_view *view) {
 	}
 	c->marks = create_list();
 	c->outputs = create_list();
+	hash_table_set_id(root->containers_by_id, c->node.id, c);
 
 	wl_signal_init(&c->events.destroy);
 	wl_signal_emit(&root->events.new_node, &c->node);
@@ -50,6 +58,13 @@ struct sway_container *container_create(struct sway_view *view) {
 	return c;
 }
 
+static void release_text_texture(struct sway_container *con,
+		struct sway_text_texture **texture) {
+	text_texture_remove_user(*texture, con);
+	text_texture_unref(*texture);
+	*texture = NULL;
+}
+
 void container_destroy(struct sway_container *con) {
 	if (!sway_assert(con->node.destroying,
 				"Tried to free container which wasn't marked as destroying")) {
@@ -61,19 +76,25 @@ void container_destroy(struct sway_container *con) {
 	}
 	free(con->title);
 	free(con->formatted_title);
-	wlr_texture_destroy(con->title_focused);
-	wlr_texture_destroy(con->title_focused_inactive);
-	wlr_texture_destroy(con->title_unfocused);
-	wlr_texture_destroy(con->title_urgent);
+	release_text_texture(con, &con->title_focused);
+	release_text_texture(con, &con->title_focused_inactive);
+	release_text_texture(con, &con->title_unfocused);
+	release_text_texture(con, &con->title_urgent);
 	list_free(con->pending.children);
 	list_free(con->current.children);
+	list_free(con->transacted.children);
 	list_free(con->outputs);
+	ipc_json_node_finish(&con->node);
 
+	hash_table_del_id(root->containers_by_id, con->node.id, con);
+	for (int i = 0; i < con->marks->length; ++i) {
+		hash_table_del(root->marks, con->marks->items[i], con);
+	}
 	list_free_items_and_destroy(con->marks);
-	wlr_texture_destroy(con->marks_focused);
-	wlr_texture_destroy(con->marks_focused_inactive);
-	wlr_texture_destroy(con->marks_unfocused);
-	wlr_texture_destroy(con->marks_urgent);
+	release_text_texture(con, &con->marks_focused);
+	release_text_texture(con, &con->marks_focused_inactive);
+	release_text_texture(con, &con->marks_unfocused);
+	release_text_texture(con, &con->marks_urgent);
 
 	if (con->view) {
 		if (con->view->container == con) {
@@ -84,7 +105,7 @@ void container_destroy(struct sway_container *con) {
 		}
 	}
 
-	free(con);
+	pool_free(container_pool, con);
 }
 
 void container_begin_destroy(struct sway_container *con) {
@@ -425,10 +446,12 @@ struct sway_container *container_at(struct sway_workspace *workspace,
 		}
 	}
 	// Tiling (non-focused)
-	if ((c = tiling_container_at(&workspace->node, lx, ly, surface, sx, sy))) {
-		return c;
+	const struct sway_hit_region *region =
+		hit_index_lookup(workspace, lx, ly);
+	if (region && region->view) {
+		surface_at_view(region->con, lx, ly, surface, sx, sy);
 	}
-	return NULL;
+	return region ? region->con : NULL;
 }
 
 void container_for_each_child(struct sway_container *container,
@@ -494,80 +517,40 @@ struct sway_output *container_get_effective_output(struct sway_container *con) {
 	return con->outputs->items[con->outputs->length - 1];
 }
 
-static void update_title_texture(struct sway_container *con,
-		struct wlr_texture **texture, struct border_colors *class) {
+static void update_text_texture(struct sway_container *con,
+		struct sway_text_texture **texture, struct border_colors *class,
+		const char *text, bool markup) {
 	struct sway_output *output = container_get_effective_output(con);
 	if (!output) {
 		return;
 	}
-	if (*texture) {
-		wlr_texture_destroy(*texture);
-		*texture = NULL;
-	}
-	if (!con->formatted_title) {
-		return;
-	}
-
-	double scale = output->wlr_output->scale;
-	int width = 0;
-	int height = con->title_height * scale;
 
-	// We must use a non-nil cairo_t for cairo_set_font_options to work.
-	// Therefore, we cannot use cairo_create(NULL).
-#ifdef HAVE_FONTS
-	cairo_surface_t *dummy_surface = cairo_image_surface_create(
-			CAIRO_FORMAT_ARGB32, 0, 0);
-	cairo_t *c = cairo_create(dummy_surface);
-	cairo_set_antialias(c, CAIRO_ANTIALIAS_BEST);
-	cairo_font_options_t *fo = cairo_font_options_create();
-	cairo_font_options_set_hint_style(fo, CAIRO_HINT_STYLE_FULL);
-	if (output->wlr_output->subpixel == WL_OUTPUT_SUBPIXEL_NONE) {
-		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_GRAY);
-	} else {
-		cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_SUBPIXEL);
-		cairo_font_options_set_subpixel_order(fo,
-			to_cairo_subpixel_order(output->wlr_output->subpixel));
-	}
-	cairo_set_font_options(c, fo);
-	get_text_size(c, config->font, &width, NULL, NULL, scale,
-			config->pango_markup, "%s", con->formatted_title);
-	cairo_surface_destroy(dummy_surface);
-	cairo_destroy(c);
-#endif
+	struct sway_text_texture_key key = {
+		.text = text,
+		.font = config->font,
+		.markup = markup,
+		.scale = output->wlr_output->scale,
+		.height = con->title_height * output->wlr_output->scale,
+		.subpixel = output->wlr_output->subpixel,
+		.renderer = wlr_backend_get_renderer(output->wlr_output->backend),
+	};
+	memcpy(key.foreground, class->text, sizeof(key.foreground));
+	memcpy(key.background, class->background, sizeof(key.background));
 
-	if (width == 0 || height == 0) {
-		return;
-	}
+	// Take the new reference first, so that an unchanged texture isn't
+	// evicted and rendered again. The old texture is rendered until the new
+	// one is ready.
+	struct sway_text_texture *old = *texture;
+	*texture = text_texture_get(&key, old);
+	text_texture_remove_user(old, con);
+	text_texture_add_user(*texture, con);
+	text_texture_unref(old);
+}
 
-#ifdef HAVE_FONTS
-	cairo_surface_t *surface = cairo_image_surface_create(
-			CAIRO_FORMAT_ARGB32, width, height);
-	cairo_t *cairo = cairo_create(surface);
-	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
-	cairo_set_font_options(cairo, fo);
-	cairo_font_options_destroy(fo);
-	cairo_set_source_rgba(cairo, class->background[0], class->background[1],
-			class->background[2], class->background[3]);
-	cairo_paint(cairo);
-	PangoContext *pango = pango_cairo_create_context(cairo);
-	cairo_set_source_rgba(cairo, class->text[0], class->text[1],
-			class->text[2], class->text[3]);
-	cairo_move_to(cairo, 0, 0);
-
-	pango_printf(cairo, config->font, scale, config->pango_markup,
-			"%s", con->formatted_title);
-
-	cairo_surface_flush(surface);
-	unsigned char *data = cairo_image_surface_get_data(surface);
-	int stride = cairo_image_surface_get_stride(surface);
-	struct wlr_renderer *renderer = wlr_backend_get_renderer(
-			output->wlr_output->backend);
-	*texture = wlr_texture_from_pixels(
-			renderer, DRM_FORMAT_ARGB8888, stride, width, height, data);
-	cairo_surface_destroy(surface);
-	g_object_unref(pango);
-	cairo_destroy(cairo);
-#endif
+static void update_title_texture(struct sway_container *con,
+		struct sway_text_texture **texture, struct border_colors *class) {
+	update_text_texture(con, texture, class, con->formatted_title,
+		config->pango_markup);
 }
 
 void container_update_title_textures(struct sway_container *container) {
@@ -582,6 +565,11 @@ void container_update_title_textures(struct sway_container *container) {
 	container_damage_whole(container);
 }
 
+void handle_text_texture_ready(struct wl_listener *listener, void *data) {
+	struct sway_container *con = data;
+	container_damage_whole(con);
+}
+
 void container_calculate_title_height(struct sway_container *container) {
 #ifdef HAVE_FONTS
 	if (!container->formatted_title) {
@@ -655,6 +643,7 @@ size_t container_build_representation(enum sway_container_layout layout,
 }
 
 void container_update_representation(struct sway_container *con) {
+	ipc_json_invalidate_node(&con->node);
 	if (!con->view) {
 		size_t len = container_build_representation(con->pending.layout,
 				con->pending.children, NULL);
@@ -1073,6 +1062,7 @@ static void container_fullscreen_workspace(struct sway_container *con) {
 	}
 	set_fullscreen(con, true);
 	con->pending.fullscreen_mode = FULLSCREEN_WORKSPACE;
+	ipc_json_invalidate_all();
 
 	con->saved_x = con->pending.x;
 	con->saved_y = con->pending.y;
@@ -1122,6 +1112,8 @@ static void container_fullscreen_global(struct sway_container *con) {
 	}
 
 	con->pending.fullscreen_mode = FULLSCREEN_GLOBAL;
+	root->tree_serial++;
+	ipc_json_invalidate_all();
 	container_end_mouse_operation(con);
 	ipc_event_window(con, "fullscreen_mode");
 }
@@ -1163,6 +1155,9 @@ void container_fullscreen_disable(struct sway_container *con) {
 	}
 
 	con->pending.fullscreen_mode = FULLSCREEN_NONE;
+	root->tree_serial++;
+	node_set_layout_dirty(&con->node);
+	ipc_json_invalidate_all();
 	container_end_mouse_operation(con);
 	ipc_event_window(con, "fullscreen_mode");
 
@@ -1356,6 +1351,8 @@ void container_handle_fullscreen_reparent(struct sway_container *con) {
 
 static void set_workspace(struct sway_container *container, void *data) {
 	container->pending.workspace = container->pending.parent->pending.workspace;
+	// Gaps and borders depend on the ancestors, which have changed
+	container->node.layout_dirty = true;
 }
 
 void container_insert_child(struct sway_container *parent,
@@ -1366,6 +1363,8 @@ void container_insert_child(struct sway_container *parent,
 	sway_list_insert(parent->pending.children, i, child);
 	child->pending.parent = parent;
 	child->pending.workspace = parent->pending.workspace;
+	root->tree_serial++;
+	node_set_layout_dirty(&child->node);
 	container_for_each_child(child, set_workspace, NULL);
 	container_handle_fullscreen_reparent(child);
 	container_update_representation(parent);
@@ -1381,6 +1380,8 @@ void container_add_sibling(struct sway_container *fixed,
 	sway_list_insert(siblings, index + after, active);
 	active->pending.parent = fixed->pending.parent;
 	active->pending.workspace = fixed->pending.workspace;
+	root->tree_serial++;
+	node_set_layout_dirty(&active->node);
 	container_for_each_child(active, set_workspace, NULL);
 	container_handle_fullscreen_reparent(active);
 	container_update_representation(active);
@@ -1394,6 +1395,8 @@ void container_add_child(struct sway_container *parent,
 	list_add(parent->pending.children, child);
 	child->pending.parent = parent;
 	child->pending.workspace = parent->pending.workspace;
+	root->tree_serial++;
+	node_set_layout_dirty(&child->node);
 	container_for_each_child(child, set_workspace, NULL);
 	container_handle_fullscreen_reparent(child);
 	container_update_representation(parent);
@@ -1421,13 +1424,16 @@ void container_detach(struct sway_container *child) {
 	child->pending.parent = NULL;
 	child->pending.workspace = NULL;
 	container_for_each_child(child, set_workspace, NULL);
+	root->tree_serial++;
 
 	if (old_parent) {
 		container_update_representation(old_parent);
 		node_set_dirty(&old_parent->node);
+		node_set_layout_dirty(&old_parent->node);
 	} else if (old_workspace) {
 		workspace_update_representation(old_workspace);
 		node_set_dirty(&old_workspace->node);
+		node_set_layout_dirty(&old_workspace->node);
 	}
 	node_set_dirty(&child->node);
 }
@@ -1488,6 +1494,7 @@ struct sway_container *container_split(struct sway_container *child,
 					child->pending.workspace->layout = layout;
 					workspace_update_representation(child->pending.workspace);
 				}
+				node_set_layout_dirty(node_get_parent(&child->node));
 				return child;
 			}
 		}
@@ -1534,18 +1541,13 @@ bool container_is_transient_for(struct sway_container *child,
 		view_is_transient_for(child->view, ancestor->view);
 }
 
-static bool find_by_mark_iterator(struct sway_container *con, void *data) {
-	char *mark = data;
-	return container_has_mark(con, mark);
-}
-
 struct sway_container *container_find_mark(char *mark) {
-	return root_find_container(find_by_mark_iterator, mark);
+	struct sway_container *con = hash_table_get(root->marks, mark);
+	return con && root_has_container(con) ? con : NULL;
 }
 
 bool container_find_and_unmark(char *mark) {
-	struct sway_container *con = root_find_container(
-		find_by_mark_iterator, mark);
+	struct sway_container *con = container_find_mark(mark);
 	if (!con) {
 		return false;
 	}
@@ -1553,6 +1555,7 @@ bool container_find_and_unmark(char *mark) {
 	for (int i = 0; i < con->marks->length; ++i) {
 		char *con_mark = con->marks->items[i];
 		if (strcmp(con_mark, mark) == 0) {
+			hash_table_del(root->marks, con_mark, con);
 			free(con_mark);
 			list_del(con->marks, i);
 			container_update_marks_textures(con);
@@ -1565,6 +1568,7 @@ bool container_find_and_unmark(char *mark) {
 
 void container_clear_marks(struct sway_container *con) {
 	for (int i = 0; i < con->marks->length; ++i) {
+		hash_table_del(root->marks, con->marks->items[i], con);
 		free(con->marks->items[i]);
 	}
 	con->marks->length = 0;
@@ -1583,20 +1587,17 @@ bool container_has_mark(struct sway_container *con, char *mark) {
 
 void container_add_mark(struct sway_container *con, char *mark) {
 	list_add(con->marks, strdup(mark));
+	hash_table_set(root->marks, mark, con);
 	ipc_event_window(con, "mark");
 }
 
 static void update_marks_texture(struct sway_container *con,
-		struct wlr_texture **texture, struct border_colors *class) {
-	struct sway_output *output = container_get_effective_output(con);
-	if (!output) {
+		struct sway_text_texture **texture, struct border_colors *class) {
+	if (!container_get_effective_output(con)) {
 		return;
 	}
-	if (*texture) {
-		wlr_texture_destroy(*texture);
-		*texture = NULL;
-	}
 	if (!con->marks->length) {
+		release_text_texture(con, texture);
 		return;
 	}
 
@@ -1612,6 +1613,7 @@ static void update_marks_texture(struct sway_container *con,
 
 	if (!sway_assert(buffer && part, "Unable to allocate memory")) {
 		free(buffer);
+		free(part);
 		return;
 	}
 
@@ -1624,48 +1626,8 @@ static void update_marks_texture(struct sway_container *con,
 	}
 	free(part);
 
-	double scale = output->wlr_output->scale;
-	int width = 0;
-	int height = con->title_height * scale;
-
-#ifdef HAVE_FONTS
-	cairo_t *c = cairo_create(NULL);
-	get_text_size(c, config->font, &width, NULL, NULL, scale, false,
-			"%s", buffer);
-	cairo_destroy(c);
-#endif
-
-	if (width == 0 || height == 0) {
-		return;
-	}
-
-#ifdef HAVE_FONTS
-	cairo_surface_t *surface = cairo_image_surface_create(
-			CAIRO_FORMAT_ARGB32, width, height);
-	cairo_t *cairo = cairo_create(surface);
-	cairo_set_source_rgba(cairo, class->background[0], class->background[1],
-			class->background[2], class->background[3]);
-	cairo_paint(cairo);
-	PangoContext *pango = pango_cairo_create_context(cairo);
-	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
-	cairo_set_source_rgba(cairo, class->text[0], class->text[1],
-			class->text[2], class->text[3]);
-	cairo_move_to(cairo, 0, 0);
-
-	pango_printf(cairo, config->font, scale, false, "%s", buffer);
-
-	cairo_surface_flush(surface);
-	unsigned char *data = cairo_image_surface_get_data(surface);
-	int stride = cairo_image_surface_get_stride(surface);
-	struct wlr_renderer *renderer = wlr_backend_get_renderer(
-			output->wlr_output->backend);
-	*texture = wlr_texture_from_pixels(
-			renderer, DRM_FORMAT_ARGB8888, stride, width, height, data);
-	cairo_surface_destroy(surface);
-	g_object_unref(pango);
-	cairo_destroy(cairo);
+	update_text_texture(con, texture, class, buffer, false);
 	free(buffer);
-#endif
 }
 
 void container_update_marks_textures(struct sway_container *con) {
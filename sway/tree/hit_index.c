@@ -0,0 +1,231 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sway/tree/container.h"
+#include "sway/tree/hit_index.h"
+#include "sway/tree/workspace.h"
+#include "list.h"
+#include "log.h"
+
+// Size of a grid cell in layout pixels
+#define HIT_INDEX_CELL_SIZE 64
+
+struct clip {
+	double x1, y1, x2, y2;
+};
+
+static void add_region(struct sway_hit_index *index, const struct clip *clip,
+		double x, double y, double width, double height,
+		struct sway_container *con, bool view) {
+	struct sway_hit_region region = {
+		.x1 = fmax(x, clip->x1),
+		.y1 = fmax(y, clip->y1),
+		.x2 = fmin(x + width, clip->x2),
+		.y2 = fmin(y + height, clip->y2),
+		.con = con,
+		.view = view,
+	};
+	if (region.x1 >= region.x2 || region.y1 >= region.y2) {
+		return;
+	}
+	if (index->regions_len == index->regions_cap) {
+		size_t cap = index->regions_cap ? index->regions_cap * 2 : 32;
+		struct sway_hit_region *regions =
+			realloc(index->regions, cap * sizeof(struct sway_hit_region));
+		if (!sway_assert(regions, "Unable to allocate hit regions")) {
+			return;
+		}
+		index->regions = regions;
+		index->regions_cap = cap;
+	}
+	index->regions[index->regions_len++] = region;
+}
+
+static void add_node(struct sway_hit_index *index, const struct clip *clip,
+		struct sway_container *con);
+
+/**
+ * Mirrors tiling_container_at, for the current state of a container or
+ * workspace.
+ */
+static void add_children(struct sway_hit_index *index, const struct clip *clip,
+		list_t *children, enum sway_container_layout layout,
+		double x, double y, double width, double height,
+		struct sway_container *active) {
+	if (!children || !children->length) {
+		return;
+	}
+	struct clip inner = {
+		.x1 = fmax(x, clip->x1),
+		.y1 = fmax(y, clip->y1),
+		.x2 = fmin(x + width, clip->x2),
+		.y2 = fmin(y + height, clip->y2),
+	};
+	int title_height = container_titlebar_height();
+
+	switch (layout) {
+	case L_HORIZ:
+	case L_VERT:
+		for (int i = 0; i < children->length; ++i) {
+			add_node(index, clip, children->items[i]);
+		}
+		return;
+	case L_TABBED: {
+		int tab_width = (int)width / children->length;
+		for (int i = 0; tab_width > 0 && i < children->length; ++i) {
+			// The last tab takes the rounding remainder
+			double tab_x = x + i * tab_width;
+			double w = i == children->length - 1 ?
+				x + width - tab_x : tab_width;
+			add_region(index, &inner, tab_x, y, w, title_height,
+				children->items[i], false);
+		}
+		break;
+	}
+	case L_STACKED:
+		for (int i = 0; title_height > 0 && i < children->length; ++i) {
+			add_region(index, &inner, x, y + i * title_height,
+				width, title_height, children->items[i], false);
+		}
+		break;
+	case L_NONE:
+		return;
+	}
+	if (active) {
+		add_node(index, &inner, active);
+	}
+}
+
+static void add_node(struct sway_hit_index *index, const struct clip *clip,
+		struct sway_container *con) {
+	struct sway_container_state *state = &con->current;
+	if (con->view) {
+		add_region(index, clip, state->x, state->y,
+			state->width, state->height, con, true);
+		return;
+	}
+	add_children(index, clip, state->children, state->layout,
+		state->x, state->y, state->width, state->height,
+		state->focused_inactive_child);
+}
+
+static bool build_grid(struct sway_hit_index *index,
+		struct sway_workspace_state *state) {
+	index->x = state->x;
+	index->y = state->y;
+	index->cols = (state->width + HIT_INDEX_CELL_SIZE - 1) / HIT_INDEX_CELL_SIZE;
+	index->rows = (state->height + HIT_INDEX_CELL_SIZE - 1) / HIT_INDEX_CELL_SIZE;
+	if (index->cols <= 0 || index->rows <= 0) {
+		index->cols = index->rows = 0;
+		return true;
+	}
+	size_t ncells = (size_t)index->cols * index->rows;
+
+	free(index->cell_start);
+	index->cell_start = calloc(ncells + 1, sizeof(uint32_t));
+	if (!sway_assert(index->cell_start, "Unable to allocate hit index")) {
+		return false;
+	}
+
+	// Count the regions of each cell, then fill the cells in region order so
+	// each cell keeps the search order of the tree
+	for (int pass = 0; pass < 2; ++pass) {
+		for (size_t i = 0; i < index->regions_len; ++i) {
+			struct sway_hit_region *region = &index->regions[i];
+			int col1 = fmax(0, (region->x1 - index->x) / HIT_INDEX_CELL_SIZE);
+			int row1 = fmax(0, (region->y1 - index->y) / HIT_INDEX_CELL_SIZE);
+			int col2 = fmin(index->cols - 1,
+				ceil((region->x2 - index->x) / HIT_INDEX_CELL_SIZE) - 1);
+			int row2 = fmin(index->rows - 1,
+				ceil((region->y2 - index->y) / HIT_INDEX_CELL_SIZE) - 1);
+			for (int row = row1; row <= row2; ++row) {
+				for (int col = col1; col <= col2; ++col) {
+					size_t cell = (size_t)row * index->cols + col;
+					if (pass == 0) {
+						index->cell_start[cell + 1]++;
+					} else {
+						index->cell_regions[index->cell_start[cell]++] = i;
+					}
+				}
+			}
+		}
+		if (pass == 0) {
+			for (size_t cell = 0; cell < ncells; ++cell) {
+				index->cell_start[cell + 1] += index->cell_start[cell];
+			}
+			size_t total = index->cell_start[ncells];
+			if (total > index->cell_regions_cap) {
+				uint32_t *cell_regions = realloc(index->cell_regions,
+					total * sizeof(uint32_t));
+				if (!sway_assert(cell_regions,
+							"Unable to allocate hit index")) {
+					return false;
+				}
+				index->cell_regions = cell_regions;
+				index->cell_regions_cap = total;
+			}
+		}
+	}
+	// Filling advanced every start to the start of the next cell
+	memmove(&index->cell_start[1], &index->cell_start[0],
+		ncells * sizeof(uint32_t));
+	index->cell_start[0] = 0;
+	return true;
+}
+
+static void hit_index_rebuild(struct sway_hit_index *index,
+		struct sway_workspace *ws) {
+	struct sway_workspace_state *state = &ws->current;
+	struct clip clip = {
+		.x1 = state->x,
+		.y1 = state->y,
+		.x2 = state->x + state->width,
+		.y2 = state->y + state->height,
+	};
+	index->regions_len = 0;
+	add_children(index, &clip, state->tiling, state->layout,
+		state->x, state->y, state->width, state->height,
+		state->focused_inactive_child);
+	if (!build_grid(index, state)) {
+		index->regions_len = 0;
+		index->cols = index->rows = 0;
+	}
+	index->valid = true;
+}
+
+void hit_index_invalidate(struct sway_hit_index *index) {
+	index->valid = false;
+}
+
+void hit_index_finish(struct sway_hit_index *index) {
+	free(index->regions);
+	free(index->cell_start);
+	free(index->cell_regions);
+	memset(index, 0, sizeof(struct sway_hit_index));
+}
+
+const struct sway_hit_region *hit_index_lookup(struct sway_workspace *ws,
+		double lx, double ly) {
+	struct sway_hit_index *index = &ws->hit_index;
+	if (!index->valid) {
+		hit_index_rebuild(index, ws);
+	}
+	int col = floor((lx - index->x) / HIT_INDEX_CELL_SIZE);
+	int row = floor((ly - index->y) / HIT_INDEX_CELL_SIZE);
+	if (col < 0 || col >= index->cols || row < 0 || row >= index->rows) {
+		return NULL;
+	}
+	size_t cell = (size_t)row * index->cols + col;
+	for (uint32_t i = index->cell_start[cell];
+			i < index->cell_start[cell + 1]; ++i) {
+		const struct sway_hit_region *region =
+			&index->regions[index->cell_regions[i]];
+		if (lx >= region->x1 && lx < region->x2 &&
+				ly >= region->y1 && ly < region->y2 &&
+				!region->con->node.destroying) {
+			return region;
+		}
+	}
+	return NULL;
+}
@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#include "sway/ipc-json.h"
 #include "sway/output.h"
 #include "sway/server.h"
 #include "sway/tree/container.h"
@@ -12,6 +13,7 @@ void node_init(struct sway_node *node, enum sway_node_type type, void *thing) {
 	node->id = next_id++;
 	node->type = type;
 	node->sway_root = thing;
+	node->layout_dirty = true;
 	wl_signal_init(&node->events.destroy);
 }
 
@@ -30,6 +32,7 @@ const char *node_type_to_str(enum sway_node_type type) {
 }
 
 void node_set_dirty(struct sway_node *node) {
+	ipc_json_invalidate_node(node);
 	if (node->dirty) {
 		return;
 	}
@@ -37,6 +40,14 @@ void node_set_dirty(struct sway_node *node) {
 	list_add(server.dirty_nodes, node);
 }
 
+void node_set_layout_dirty(struct sway_node *node) {
+	while (node && (node->type == N_CONTAINER ||
+				node->type == N_WORKSPACE)) {
+		node->layout_dirty = true;
+		node = node_get_parent(node);
+	}
+}
+
 bool node_is_view(struct sway_node *node) {
 	return node->type == N_CONTAINER && node->sway_container->view;
 }
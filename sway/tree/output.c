@@ -116,6 +116,7 @@ void output_enable(struct sway_output *output) {
 	}
 	struct wlr_output *wlr_output = output->wlr_output;
 	output->enabled = true;
+	output->render_list_dirty = true;
 	list_add(root->outputs, output);
 
 	restore_workspaces(output);
@@ -240,6 +241,7 @@ void output_destroy(struct sway_output *output) {
 	}
 	list_free(output->workspaces);
 	list_free(output->current.workspaces);
+	render_list_destroy(output->render_list);
 	wl_event_source_remove(output->repaint_timer);
 	free(output);
 }
@@ -323,6 +325,8 @@ void output_add_workspace(struct sway_output *output,
 	}
 	list_add(output->workspaces, workspace);
 	workspace->output = output;
+	root->tree_serial++;
+	node_set_layout_dirty(&workspace->node);
 	node_set_dirty(&output->node);
 	node_set_dirty(&workspace->node);
 }
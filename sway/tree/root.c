@@ -39,6 +39,10 @@ struct sway_root *root_create(void) {
 	wl_signal_init(&root->events.new_node);
 	root->outputs = create_list();
 	root->scratchpad = create_list();
+	root->containers_by_id = create_hash_table();
+	root->marks = create_hash_table();
+	root->workspaces_by_name = create_hash_table();
+	root->workspaces_by_number = create_hash_table();
 
 	root->output_layout_change.notify = output_layout_handle_change;
 	wl_signal_add(&root->output_layout->events.change,
@@ -50,6 +54,10 @@ void root_destroy(struct sway_root *root) {
 	wl_list_remove(&root->output_layout_change.link);
 	list_free(root->scratchpad);
 	list_free(root->outputs);
+	hash_table_free(root->containers_by_id);
+	hash_table_free(root->marks);
+	hash_table_free(root->workspaces_by_name);
+	hash_table_free(root->workspaces_by_number);
 	wlr_output_layout_destroy(root->output_layout);
 	free(root);
 }
@@ -380,6 +388,23 @@ void root_for_each_container(void (*f)(struct sway_container *con, void *data),
 	}
 }
 
+static void set_workspace_layout_dirty_iterator(struct sway_workspace *ws,
+		void *data) {
+	ws->node.layout_dirty = true;
+}
+
+static void set_container_layout_dirty_iterator(struct sway_container *con,
+		void *data) {
+	con->node.layout_dirty = true;
+}
+
+void root_set_layout_dirty(void) {
+	root_for_each_workspace(set_workspace_layout_dirty_iterator, NULL);
+	output_for_each_workspace(root->noop_output,
+		set_workspace_layout_dirty_iterator, NULL);
+	root_for_each_container(set_container_layout_dirty_iterator, NULL);
+}
+
 struct sway_output *root_find_output(
 		bool (*test)(struct sway_output *output, void *data), void *data) {
 	for (int i = 0; i < root->outputs->length; ++i) {
@@ -437,6 +462,19 @@ struct sway_container *root_find_container(
 	return NULL;
 }
 
+bool root_has_container(struct sway_container *con) {
+	if (con->node.destroying) {
+		return false;
+	}
+	return con->pending.workspace ||
+		container_is_scratchpad_hidden_or_child(con);
+}
+
+struct sway_container *root_find_container_by_id(size_t id) {
+	struct sway_container *con = hash_table_get_id(root->containers_by_id, id);
+	return con && root_has_container(con) ? con : NULL;
+}
+
 void root_get_box(struct sway_root *root, struct wlr_box *box) {
 	box->x = root->x;
 	box->y = root->y;
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <float.h>
 #include <strings.h>
+#include <time.h>
 #include <wayland-server-core.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_buffer.h>
@@ -20,6 +21,7 @@
 #include "sway/desktop/transaction.h"
 #include "sway/desktop/idle_inhibit_v1.h"
 #include "sway/input/cursor.h"
+#include "sway/ipc-json.h"
 #include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/input/seat.h"
@@ -39,6 +41,7 @@ void view_init(struct sway_view *view, enum sway_view_type type,
 	view->impl = impl;
 	view->executed_criteria = create_list();
 	wl_list_init(&view->saved_buffers);
+	wl_list_init(&view->latency_link);
 	view->allow_request_urgent = true;
 	view->shortcuts_inhibit = SHORTCUTS_INHIBIT_DEFAULT;
 	wl_signal_init(&view->events.unmap);
@@ -58,6 +61,7 @@ void view_destroy(struct sway_view *view) {
 		return;
 	}
 	wl_list_remove(&view->events.unmap.listener_list);
+	wl_list_remove(&view->latency_link);
 	if (!wl_list_empty(&view->saved_buffers)) {
 		view_remove_saved_buffer(view);
 	}
@@ -412,6 +416,9 @@ void view_update_csd_from_client(struct sway_view *view, bool enabled) {
 	} else if (!enabled && con && con->pending.border == B_CSD) {
 		con->pending.border = con->saved_border;
 	}
+	if (con) {
+		node_set_layout_dirty(&con->node);
+	}
 	view->using_csd = enabled;
 }
 
@@ -491,6 +498,10 @@ static bool view_has_executed_criteria(struct sway_view *view,
 }
 
 void view_execute_criteria(struct sway_view *view) {
+	// Called when the app_id, class or other properties change
+	if (view->container) {
+		ipc_json_invalidate_node(&view->container->node);
+	}
 	list_t *criterias = criteria_for_view(view, CT_COMMAND);
 	for (int i = 0; i < criterias->length; i++) {
 		struct criteria *criteria = criterias->items[i];
@@ -844,6 +855,18 @@ void view_unmap(struct sway_view *view) {
 		view->urgent_timer = NULL;
 	}
 
+	if (view->title_timer) {
+		wl_event_source_remove(view->title_timer);
+		view->title_timer = NULL;
+	}
+	if (view->title_dirty) {
+		int index = list_find(server.dirty_titles, view);
+		if (index != -1) {
+			list_del(server.dirty_titles, index);
+		}
+		view->title_dirty = false;
+	}
+
 	if (view->foreign_toplevel) {
 		wlr_foreign_toplevel_handle_v1_destroy(view->foreign_toplevel);
 		view->foreign_toplevel = NULL;
@@ -1286,6 +1309,7 @@ void view_update_title(struct sway_view *view, bool force) {
 		view->container->title = NULL;
 		view->container->formatted_title = NULL;
 	}
+	clock_gettime(CLOCK_MONOTONIC, &view->title_updated);
 	container_calculate_title_height(view->container);
 	config_update_font_height(false);
 
@@ -1299,6 +1323,86 @@ void view_update_title(struct sway_view *view, bool force) {
 	}
 }
 
+static struct wl_event_source *title_idle = NULL;
+
+static void handle_title_idle(void *data) {
+	title_idle = NULL;
+	view_update_dirty_titles();
+}
+
+static void queue_title_update(struct sway_view *view) {
+	list_add(server.dirty_titles, view);
+
+	// Titles are updated by the next frame of any output showing the view.
+	// If there is none, nothing is waiting for a frame, so update on idle.
+	bool scheduled = false;
+	for (int i = 0; i < view->container->outputs->length; ++i) {
+		struct sway_output *output = view->container->outputs->items[i];
+		if (output->enabled && output->wlr_output->enabled) {
+			wlr_output_schedule_frame(output->wlr_output);
+			scheduled = true;
+		}
+	}
+	if (!scheduled && !title_idle) {
+		title_idle = wl_event_loop_add_idle(server.wl_event_loop,
+				handle_title_idle, NULL);
+	}
+}
+
+static int handle_title_timeout(void *data) {
+	struct sway_view *view = data;
+	wl_event_source_remove(view->title_timer);
+	view->title_timer = NULL;
+	queue_title_update(view);
+	return 0;
+}
+
+static int title_update_delay(struct sway_view *view) {
+	if (config->max_title_update_rate <= 0) {
+		return 0;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	long elapsed_ms = (now.tv_sec - view->title_updated.tv_sec) * 1000 +
+		(now.tv_nsec - view->title_updated.tv_nsec) / 1000000;
+	long interval_ms = 1000 / config->max_title_update_rate;
+	return elapsed_ms < interval_ms ? interval_ms - elapsed_ms : 0;
+}
+
+void view_request_title_update(struct sway_view *view) {
+	if (view->title_dirty) {
+		// The pending update will pick up the latest title
+		return;
+	}
+	view->title_dirty = true;
+
+	int delay = title_update_delay(view);
+	if (delay > 0) {
+		view->title_timer = wl_event_loop_add_timer(server.wl_event_loop,
+				handle_title_timeout, view);
+		if (view->title_timer) {
+			wl_event_source_timer_update(view->title_timer, delay);
+			return;
+		}
+	}
+	queue_title_update(view);
+}
+
+void view_update_dirty_titles(void) {
+	if (!server.dirty_titles->length) {
+		return;
+	}
+	for (int i = 0; i < server.dirty_titles->length; ++i) {
+		struct sway_view *view = server.dirty_titles->items[i];
+		view->title_dirty = false;
+		view_update_title(view, false);
+	}
+	server.dirty_titles->length = 0;
+
+	// A new title may have changed the title height
+	transaction_commit_dirty();
+}
+
 bool view_is_visible(struct sway_view *view) {
 	if (view->container->node.destroying) {
 		return false;
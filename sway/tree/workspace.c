@@ -9,6 +9,7 @@
 #include "sway/input/input-manager.h"
 #include "sway/input/cursor.h"
 #include "sway/input/seat.h"
+#include "sway/ipc-json.h"
 #include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/tree/arrange.h"
@@ -20,6 +21,87 @@
 #include "log.h"
 #include "util.h"
 
+// Longest digit prefix indexed in root->workspaces_by_number
+#define WORKSPACE_NUMBER_MAX 32
+
+static char *lookup_name(const char *name) {
+	char *key = strdup(name);
+	for (char *c = key; key && *c; ++c) {
+		*c = tolower((unsigned char)*c);
+	}
+	return key;
+}
+
+/**
+ * Copies the leading digits of the name into buf, which holds
+ * WORKSPACE_NUMBER_MAX characters. Returns false if there are
+ * none or if there are too many to fit.
+ */
+static bool lookup_number(const char *name, char *buf) {
+	size_t len = 0;
+	while (isdigit((unsigned char)name[len])) {
+		if (len == WORKSPACE_NUMBER_MAX - 1) {
+			return false;
+		}
+		buf[len] = name[len];
+		++len;
+	}
+	buf[len] = '\0';
+	return len > 0;
+}
+
+static void workspace_index_add(struct sway_workspace *ws) {
+	char *key = lookup_name(ws->name);
+	if (key) {
+		hash_table_set(root->workspaces_by_name, key, ws);
+		free(key);
+	}
+
+	char number[WORKSPACE_NUMBER_MAX];
+	if (!lookup_number(ws->name, number)) {
+		return;
+	}
+	list_t *list = hash_table_get(root->workspaces_by_number, number);
+	if (!list) {
+		list = create_list();
+		hash_table_set(root->workspaces_by_number, number, list);
+	}
+	list_add(list, ws);
+}
+
+static void workspace_index_remove(struct sway_workspace *ws) {
+	char *key = lookup_name(ws->name);
+	if (key) {
+		hash_table_del(root->workspaces_by_name, key, ws);
+		free(key);
+	}
+
+	char number[WORKSPACE_NUMBER_MAX];
+	if (!lookup_number(ws->name, number)) {
+		return;
+	}
+	list_t *list = hash_table_get(root->workspaces_by_number, number);
+	if (!list) {
+		return;
+	}
+	int index = list_find(list, ws);
+	if (index != -1) {
+		list_del(list, index);
+	}
+	if (!list->length) {
+		hash_table_del(root->workspaces_by_number, number, list);
+		list_free(list);
+	}
+}
+
+/**
+ * Whether the workspace is visited by root_find_workspace.
+ */
+static bool workspace_is_findable(struct sway_workspace *ws) {
+	return !ws->node.destroying && ws->output &&
+		list_find(root->outputs, ws->output) != -1;
+}
+
 struct workspace_config *workspace_find_config(const char *ws_name) {
 	for (int i = 0; i < config->workspace_configs->length; ++i) {
 		struct workspace_config *wsc = config->workspace_configs->items[i];
@@ -112,6 +194,9 @@ struct sway_workspace *workspace_create(struct sway_output *output,
 
 	output_add_workspace(output, ws);
 	output_sort_workspaces(output);
+	if (ws->name) {
+		workspace_index_add(ws);
+	}
 
 	ipc_event_workspace(NULL, ws, "init");
 	wl_signal_emit(&root->events.new_node, &ws->node);
@@ -129,13 +214,20 @@ void workspace_destroy(struct sway_workspace *workspace) {
 		return;
 	}
 
+	if (workspace->name) {
+		workspace_index_remove(workspace);
+	}
 	free(workspace->name);
 	free(workspace->representation);
+	ipc_json_node_finish(&workspace->node);
 	list_free_items_and_destroy(workspace->output_priority);
 	list_free(workspace->floating);
 	list_free(workspace->tiling);
 	list_free(workspace->current.floating);
 	list_free(workspace->current.tiling);
+	list_free(workspace->transacted.floating);
+	list_free(workspace->transacted.tiling);
+	hit_index_finish(&workspace->hit_index);
 	free(workspace);
 }
 
@@ -347,11 +439,40 @@ static bool _workspace_by_number(struct sway_workspace *ws, void *data) {
 }
 
 struct sway_workspace *workspace_by_number(const char* name) {
+	char number[WORKSPACE_NUMBER_MAX];
+	if (lookup_number(name, number)) {
+		list_t *list = hash_table_get(root->workspaces_by_number, number);
+		if (!list) {
+			return NULL;
+		}
+		if (list->length == 1) {
+			struct sway_workspace *ws = list->items[0];
+			return workspace_is_findable(ws) ? ws : NULL;
+		}
+	}
+	// Several workspaces share the number, so the first one in tree order wins
 	return root_find_workspace(_workspace_by_number, (void *) name);
 }
 
-static bool _workspace_by_name(struct sway_workspace *ws, void *data) {
-	return strcasecmp(ws->name, data) == 0;
+void workspace_set_name(struct sway_workspace *ws, char *name) {
+	if (ws->name) {
+		workspace_index_remove(ws);
+	}
+	free(ws->name);
+	ws->name = name;
+	if (ws->name) {
+		workspace_index_add(ws);
+	}
+}
+
+static struct sway_workspace *find_workspace_by_name(const char *name) {
+	char *key = lookup_name(name);
+	if (!key) {
+		return NULL;
+	}
+	struct sway_workspace *ws = hash_table_get(root->workspaces_by_name, key);
+	free(key);
+	return ws && workspace_is_findable(ws) ? ws : NULL;
 }
 
 struct sway_workspace *workspace_by_name(const char *name) {
@@ -373,10 +494,9 @@ struct sway_workspace *workspace_by_name(const char *name) {
 		if (!seat->prev_workspace_name) {
 			return NULL;
 		}
-		return root_find_workspace(_workspace_by_name,
-				(void*)seat->prev_workspace_name);
+		return find_workspace_by_name(seat->prev_workspace_name);
 	} else {
-		return root_find_workspace(_workspace_by_name, (void*)name);
+		return find_workspace_by_name(name);
 	}
 }
 
@@ -732,6 +852,8 @@ struct sway_container *workspace_find_container(struct sway_workspace *ws,
 
 static void set_workspace(struct sway_container *container, void *data) {
 	container->pending.workspace = container->pending.parent->pending.workspace;
+	// Gaps and borders depend on the ancestors, which have changed
+	container->node.layout_dirty = true;
 }
 
 static void workspace_attach_tiling(struct sway_workspace *ws,
@@ -739,6 +861,8 @@ static void workspace_attach_tiling(struct sway_workspace *ws,
 	list_add(ws->tiling, con);
 	con->pending.workspace = ws;
 	container_for_each_child(con, set_workspace, NULL);
+	root->tree_serial++;
+	node_set_layout_dirty(&con->node);
 	container_handle_fullscreen_reparent(con);
 	workspace_update_representation(ws);
 	node_set_dirty(&ws->node);
@@ -781,6 +905,7 @@ void workspace_detach(struct sway_workspace *workspace) {
 		list_del(output->workspaces, index);
 	}
 	workspace->output = NULL;
+	root->tree_serial++;
 
 	node_set_dirty(&workspace->node);
 	node_set_dirty(&output->node);
@@ -801,6 +926,8 @@ struct sway_container *workspace_add_tiling(struct sway_workspace *workspace,
 	list_add(workspace->tiling, con);
 	con->pending.workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
+	root->tree_serial++;
+	node_set_layout_dirty(&con->node);
 	container_handle_fullscreen_reparent(con);
 	workspace_update_representation(workspace);
 	node_set_dirty(&workspace->node);
@@ -816,6 +943,8 @@ void workspace_add_floating(struct sway_workspace *workspace,
 	list_add(workspace->floating, con);
 	con->pending.workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
+	root->tree_serial++;
+	node_set_layout_dirty(&con->node);
 	container_handle_fullscreen_reparent(con);
 	node_set_dirty(&workspace->node);
 	node_set_dirty(&con->node);
@@ -826,6 +955,8 @@ void workspace_insert_tiling_direct(struct sway_workspace *workspace,
 	sway_list_insert(workspace->tiling, index, con);
 	con->pending.workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
+	root->tree_serial++;
+	node_set_layout_dirty(&con->node);
 	container_handle_fullscreen_reparent(con);
 	workspace_update_representation(workspace);
 	node_set_dirty(&workspace->node);
@@ -898,6 +1029,7 @@ struct sway_container *workspace_split(struct sway_workspace *workspace,
 	if (workspace->tiling->length == 0) {
 		workspace->prev_split_layout = workspace->layout;
 		workspace->layout = layout;
+		node_set_layout_dirty(&workspace->node);
 		return NULL;
 	}
 
@@ -917,6 +1049,7 @@ struct sway_container *workspace_split(struct sway_workspace *workspace,
 }
 
 void workspace_update_representation(struct sway_workspace *ws) {
+	ipc_json_invalidate_node(&ws->node);
 	size_t len = container_build_representation(ws->layout, ws->tiling, NULL);
 	free(ws->representation);
 	ws->representation = calloc(len + 1, sizeof(char));
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <strings.h>
 #include <getopt.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <sys/un.h>
 #include <sys/socket.h>
@@ -274,6 +275,39 @@ static void pretty_print_output(json_object *o) {
 	printf("\n");
 }
 
+static void pretty_print_histogram(const char *label, json_object *h) {
+	json_object *p50, *p95, *p99;
+	json_object_object_get_ex(h, "p50", &p50);
+	json_object_object_get_ex(h, "p95", &p95);
+	json_object_object_get_ex(h, "p99", &p99);
+	printf("  %s: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms\n", label,
+		json_object_get_int64(p50) / 1000.0,
+		json_object_get_int64(p95) / 1000.0,
+		json_object_get_int64(p99) / 1000.0);
+}
+
+static void pretty_print_stats(json_object *s) {
+	json_object *name, *frames, *missed_frames;
+	json_object_object_get_ex(s, "name", &name);
+	json_object_object_get_ex(s, "frames", &frames);
+	json_object_object_get_ex(s, "missed_frames", &missed_frames);
+	json_object *render_time, *damage_to_commit, *present_interval;
+	json_object_object_get_ex(s, "render_time", &render_time);
+	json_object_object_get_ex(s, "damage_to_commit", &damage_to_commit);
+	json_object_object_get_ex(s, "present_interval", &present_interval);
+
+	printf("Output %s\n"
+		"  Frames: %" PRId64 " (%" PRId64 " missed)\n",
+		json_object_get_string(name),
+		json_object_get_int64(frames),
+		json_object_get_int64(missed_frames));
+	pretty_print_histogram("Render time", render_time);
+	pretty_print_histogram("Frame to commit", damage_to_commit);
+	pretty_print_histogram("Present interval", present_interval);
+
+	printf("\n");
+}
+
 static void pretty_print_version(json_object *v) {
 	json_object *ver;
 	json_object_object_get_ex(v, "human_readable", &ver);
@@ -290,7 +324,8 @@ static void pretty_print(int type, json_object *resp) {
 	if (type != IPC_COMMAND && type != IPC_GET_WORKSPACES &&
 			type != IPC_GET_INPUTS && type != IPC_GET_OUTPUTS &&
 			type != IPC_GET_VERSION && type != IPC_GET_SEATS &&
-			type != IPC_GET_CONFIG && type != IPC_SEND_TICK) {
+			type != IPC_GET_CONFIG && type != IPC_SEND_TICK &&
+			type != IPC_GET_STATS) {
 		printf("%s\n", json_object_to_json_string_ext(resp,
 			JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_SPACED));
 		return;
@@ -330,6 +365,9 @@ static void pretty_print(int type, json_object *resp) {
 		case IPC_GET_SEATS:
 			pretty_print_seat(obj);
 			break;
+		case IPC_GET_STATS:
+			pretty_print_stats(obj);
+			break;
 		}
 	}
 }
@@ -442,6 +480,16 @@ int main(int argc, char **argv) {
 		type = IPC_GET_BINDING_MODES;
 	} else if (strcasecmp(cmdtype, "get_binding_state") == 0) {
 		type = IPC_GET_BINDING_STATE;
+	} else if (strcasecmp(cmdtype, "get_stats") == 0) {
+		type = IPC_GET_STATS;
+	} else if (strcasecmp(cmdtype, "get_transactions") == 0) {
+		type = IPC_GET_TRANSACTIONS;
+	} else if (strcasecmp(cmdtype, "hit_test") == 0) {
+		type = IPC_HIT_TEST;
+	} else if (strcasecmp(cmdtype, "get_pools") == 0) {
+		type = IPC_GET_POOLS;
+	} else if (strcasecmp(cmdtype, "get_clients") == 0) {
+		type = IPC_GET_CLIENTS;
 	} else if (strcasecmp(cmdtype, "get_config") == 0) {
 		type = IPC_GET_CONFIG;
 	} else if (strcasecmp(cmdtype, "send_tick") == 0) {